@@ -0,0 +1,664 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "AsyncExecutor.hpp"
+#include "Connection.hpp"
+#include "Cursor.hpp"
+#include "RowReader.hpp"
+#include "StatementCache.hpp"
+
+#include <conncpp.hpp>
+
+#include <IPreparedStatement.hpp>
+
+#include <algorithm>
+#include <chrono>
+
+namespace Luna::MDBSQL
+{
+    struct AsyncExecutor::Stream
+    {
+        std::shared_ptr<CursorBuffer> cursor;
+        Connection *connection;
+        std::string sql;
+        std::vector<Value> params;
+        // Declared before the result set, they have to outlive it
+        std::unique_ptr<sql::Statement> statement;
+        std::unique_ptr<sql::PreparedStatement> prepared;
+        std::unique_ptr<sql::ResultSet> resultSet;
+        std::vector<ColumnType> types;
+    };
+
+    AsyncExecutor::AsyncExecutor() = default;
+
+    AsyncExecutor::~AsyncExecutor()
+    {
+        stop();
+    }
+
+    void AsyncExecutor::start(std::size_t workers)
+    {
+        if (!m_workers.empty())
+        {
+            return;
+        }
+
+        for (std::size_t i = 0; i < std::max<std::size_t>(workers, 1); i++)
+        {
+            m_workers.emplace_back(&AsyncExecutor::_work, this);
+        }
+    }
+
+    void AsyncExecutor::stop()
+    {
+        {
+            std::lock_guard lock(m_jobsMutex);
+            m_stopping = true;
+            _closeCursors(nullptr);
+        }
+
+        m_jobsCond.notify_all();
+
+        for (auto &worker : m_workers)
+        {
+            worker.join();
+        }
+
+        m_workers.clear();
+
+        // Parked streams are not continued anymore, their queries are closed here
+        std::lock_guard lock(m_jobsMutex);
+        m_jobs.clear();
+        m_streams.clear();
+        m_stopping = false;
+    }
+
+    IAsyncExecutor::JobId AsyncExecutor::submit(IConnection &connection, Kind kind, std::string_view sql,
+                                                std::vector<Value> &&params)
+    {
+        return _submit(
+            {0, &static_cast<Connection &>(connection), kind, std::string {sql}, std::move(params), 0, nullptr});
+    }
+
+    IAsyncExecutor::JobId AsyncExecutor::submitBatch(IConnection &connection, std::string_view sql,
+                                                     std::vector<Value> &&values, std::size_t columns)
+    {
+        return _submit(
+            {0, &static_cast<Connection &>(connection), Kind::Batch, std::string {sql}, std::move(values), columns,
+             nullptr});
+    }
+
+    std::unique_ptr<ICursor> AsyncExecutor::openCursor(IConnection &connection, std::string_view sql,
+                                                       std::vector<Value> &&params, std::size_t fetchSize,
+                                                       std::size_t maxBuffered)
+    {
+        auto buffer = std::make_shared<CursorBuffer>(fetchSize, maxBuffered);
+
+        _submit({0, &static_cast<Connection &>(connection), Kind::Cursor, std::string {sql}, std::move(params), 0,
+                 buffer});
+
+        return std::make_unique<Cursor>(std::move(buffer), *this);
+    }
+
+    void AsyncExecutor::resumeCursor(const std::shared_ptr<CursorBuffer> &cursor)
+    {
+        {
+            std::lock_guard lock(m_jobsMutex);
+
+            // Gone when the executor was stopped
+            Stream *stream = _findStream(cursor.get());
+
+            if (!stream)
+            {
+                return;
+            }
+
+            m_jobs.push_back({0, stream->connection, Kind::Cursor, {}, {}, 0, cursor});
+        }
+
+        m_jobsCond.notify_one();
+    }
+
+    IAsyncExecutor::JobId AsyncExecutor::_submit(Job &&job)
+    {
+        JobId id;
+
+        {
+            std::lock_guard lock(m_jobsMutex);
+
+            id = job.id = m_nextId++;
+            m_jobs.push_back(std::move(job));
+        }
+
+        m_jobsCond.notify_one();
+        return id;
+    }
+
+    void AsyncExecutor::release(IConnection &connection)
+    {
+        auto conn = &static_cast<Connection &>(connection);
+        std::vector<JobId> dropped;
+
+        std::unique_lock lock(m_jobsMutex);
+
+        _closeCursors(conn);
+
+        for (auto it = m_jobs.begin(); it != m_jobs.end();)
+        {
+            if (it->connection != conn)
+            {
+                ++it;
+                continue;
+            }
+
+            // Continuations close the query of a parked cursor
+            if (it->cursor && _findStream(it->cursor.get()) && !m_workers.empty())
+            {
+                ++it;
+                continue;
+            }
+
+            // Cursors report the failure themselves
+            if (it->cursor)
+            {
+                it->cursor->finish("Connection was closed");
+            }
+            else
+            {
+                dropped.push_back(it->id);
+            }
+
+            it = m_jobs.erase(it);
+        }
+
+        if (m_workers.empty())
+        {
+            m_streams.erase(std::remove_if(m_streams.begin(), m_streams.end(),
+                                           [conn](const std::unique_ptr<Stream> &stream)
+                                           {
+                                               return stream->connection == conn;
+                                           }),
+                            m_streams.end());
+        }
+
+        // The connection cannot be destroyed while a worker is still using it
+        m_idleCond.wait(lock,
+                        [this, conn]()
+                        {
+                            return !_hasJobs(conn) && !_isBusy(conn);
+                        });
+
+        lock.unlock();
+
+        for (JobId id : dropped)
+        {
+            _complete({id, false, "Connection was closed", 0, {}, 0});
+        }
+    }
+
+    void AsyncExecutor::drain(IConnection &connection)
+    {
+        auto conn = &static_cast<Connection &>(connection);
+
+        std::unique_lock lock(m_jobsMutex);
+
+        // Nothing would pick the jobs up
+        if (m_workers.empty())
+        {
+            return;
+        }
+
+        // Nobody takes rows from a cursor while the game thread waits here, parked ones are continued to close
+        _closeCursors(conn);
+
+        m_idleCond.wait(lock,
+                        [this, conn]()
+                        {
+                            return !_hasJobs(conn) && !_isBusy(conn);
+                        });
+    }
+
+    bool AsyncExecutor::isBusy(IConnection &connection) const
+    {
+        auto conn = &static_cast<Connection &>(connection);
+
+        std::lock_guard lock(m_jobsMutex);
+        return _hasJobs(conn) || _isBusy(conn) || _findStream(conn);
+    }
+
+    std::size_t AsyncExecutor::poll(std::vector<Completion> &completions, std::size_t max)
+    {
+        std::lock_guard lock(m_completionsMutex);
+
+        std::size_t count = std::min(max, m_completions.size());
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            completions.push_back(std::move(m_completions.front()));
+            m_completions.pop_front();
+        }
+
+        return count;
+    }
+
+    IAsyncExecutor::Stats AsyncExecutor::getStats() const
+    {
+        Stats stats {};
+
+        {
+            std::lock_guard lock(m_jobsMutex);
+            stats.queued = m_jobs.size();
+            stats.running = m_busy.size();
+        }
+
+        std::lock_guard lock(m_completionsMutex);
+        stats.completed = m_completions.size();
+        stats.processed = m_processed;
+
+        return stats;
+    }
+
+    void AsyncExecutor::_work()
+    {
+        std::unique_lock lock(m_jobsMutex);
+
+        while (true)
+        {
+            auto job = m_jobs.end();
+
+            // Take the oldest job that can run now, this keeps per connection order
+            m_jobsCond.wait(lock,
+                            [this, &job]()
+                            {
+                                if (m_stopping)
+                                {
+                                    return true;
+                                }
+
+                                job = std::find_if(m_jobs.begin(), m_jobs.end(),
+                                                   [this](const Job &other)
+                                                   {
+                                                       return _canRun(other);
+                                                   });
+
+                                return job != m_jobs.end();
+                            });
+
+            if (m_stopping)
+            {
+                return;
+            }
+
+            Job current = std::move(*job);
+            m_jobs.erase(job);
+            m_busy.push_back(current.connection);
+
+            if (current.kind == Kind::Cursor)
+            {
+                Stream &stream = _openStream(current);
+
+                lock.unlock();
+                bool parked = _runCursor(stream);
+                lock.lock();
+
+                // Parked streams keep the connection until their cursor is continued
+                if (!parked)
+                {
+                    _closeStream(stream);
+                }
+            }
+            else
+            {
+                lock.unlock();
+
+                Completion completion {current.id, true, {}, 0, {}, 0};
+                auto started = std::chrono::steady_clock::now();
+
+                if (current.kind == Kind::Batch)
+                {
+                    _runBatch(current, completion);
+                }
+                else
+                {
+                    _run(current, completion);
+                }
+
+                completion.elapsedUs = static_cast<std::uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - started)
+                        .count());
+
+                _complete(std::move(completion));
+
+                lock.lock();
+            }
+
+            m_busy.erase(std::find(m_busy.begin(), m_busy.end(), current.connection));
+
+            m_jobsCond.notify_all();
+            m_idleCond.notify_all();
+        }
+    }
+
+    bool AsyncExecutor::_canRun(const Job &job) const
+    {
+        if (_isBusy(job.connection))
+        {
+            return false;
+        }
+
+        // Only the cursor streaming on the connection may use it
+        const Stream *stream = _findStream(job.connection);
+
+        return !stream || stream->cursor == job.cursor;
+    }
+
+    bool AsyncExecutor::_isBusy(const Connection *connection) const
+    {
+        return std::find(m_busy.begin(), m_busy.end(), connection) != m_busy.end();
+    }
+
+    bool AsyncExecutor::_hasJobs(const Connection *connection) const
+    {
+        return std::any_of(m_jobs.begin(), m_jobs.end(),
+                           [connection](const Job &job)
+                           {
+                               return job.connection == connection;
+                           });
+    }
+
+    AsyncExecutor::Stream *AsyncExecutor::_findStream(const Connection *connection) const
+    {
+        auto it = std::find_if(m_streams.begin(), m_streams.end(),
+                               [connection](const std::unique_ptr<Stream> &stream)
+                               {
+                                   return stream->connection == connection;
+                               });
+
+        return it != m_streams.end() ? it->get() : nullptr;
+    }
+
+    AsyncExecutor::Stream *AsyncExecutor::_findStream(const CursorBuffer *cursor) const
+    {
+        auto it = std::find_if(m_streams.begin(), m_streams.end(),
+                               [cursor](const std::unique_ptr<Stream> &stream)
+                               {
+                                   return stream->cursor.get() == cursor;
+                               });
+
+        return it != m_streams.end() ? it->get() : nullptr;
+    }
+
+    AsyncExecutor::Stream &AsyncExecutor::_openStream(Job &job)
+    {
+        if (Stream *stream = _findStream(job.cursor.get()); stream)
+        {
+            return *stream;
+        }
+
+        auto stream = std::make_unique<Stream>();
+        stream->cursor = job.cursor;
+        stream->connection = job.connection;
+        stream->sql = std::move(job.sql);
+        stream->params = std::move(job.params);
+
+        return *m_streams.emplace_back(std::move(stream));
+    }
+
+    void AsyncExecutor::_closeStream(const Stream &stream)
+    {
+        m_streams.erase(std::find_if(m_streams.begin(), m_streams.end(),
+                                     [&stream](const std::unique_ptr<Stream> &other)
+                                     {
+                                         return other.get() == &stream;
+                                     }));
+    }
+
+    void AsyncExecutor::_closeCursors(const Connection *connection)
+    {
+        for (const Job &job : m_jobs)
+        {
+            if (job.cursor && (!connection || job.connection == connection))
+            {
+                job.cursor->close();
+            }
+        }
+
+        for (const auto &stream : m_streams)
+        {
+            // A worker has to close the query of a parked stream
+            if ((!connection || stream->connection == connection) && stream->cursor->close())
+            {
+                m_jobs.push_back({0, stream->connection, Kind::Cursor, {}, {}, 0, stream->cursor});
+            }
+        }
+
+        m_jobsCond.notify_all();
+    }
+
+    void AsyncExecutor::_complete(Completion &&completion)
+    {
+        std::lock_guard lock(m_completionsMutex);
+
+        m_completions.push_back(std::move(completion));
+        m_processed++;
+    }
+
+    void AsyncExecutor::_run(Job &job, Completion &completion)
+    {
+        try
+        {
+            auto connection = static_cast<sql::Connection *>(*job.connection);
+            // Declared before the result set, it has to outlive it
+            std::unique_ptr<sql::Statement> statement;
+            std::unique_ptr<sql::ResultSet> resultSet;
+
+            if (job.params.empty())
+            {
+                statement.reset(connection->createStatement());
+
+                if (job.kind == Kind::Update)
+                {
+                    completion.updateCount = statement->executeLargeUpdate(job.sql);
+                    return;
+                }
+
+                resultSet.reset(statement->executeQuery(job.sql));
+            }
+            else
+            {
+                StatementCache &cache = job.connection->getStatementCache();
+                std::unique_ptr<sql::PreparedStatement> prepared = cache.acquire(job.sql);
+                bindParams(*prepared, job.params);
+
+                if (job.kind == Kind::Update)
+                {
+                    completion.updateCount = prepared->executeLargeUpdate();
+                }
+                else
+                {
+                    resultSet.reset(prepared->executeQuery());
+                    readRows(*resultSet, completion.rows);
+                }
+
+                // Result set is fully read so the statement can be reused
+                resultSet.reset();
+                cache.release(std::move(job.sql), std::move(prepared));
+                return;
+            }
+
+            readRows(*resultSet, completion.rows);
+        }
+        catch (const std::exception &e)
+        {
+            completion.success = false;
+            completion.error = e.what();
+        }
+    }
+
+    void AsyncExecutor::_runBatch(Job &job, Completion &completion)
+    {
+        Connection &connection = *job.connection;
+        auto conn = static_cast<sql::Connection *>(connection);
+        // A transaction or commit group left open takes the batch in, the batch is committed with it
+        std::unique_ptr<sql::Savepoint> savepoint;
+        bool began = false;
+
+        try
+        {
+            if (connection.getAutoCommit())
+            {
+                connection.begin();
+                began = true;
+            }
+            else
+            {
+                savepoint.reset(conn->setSavepoint("luna_batch"));
+            }
+
+            {
+                std::unique_ptr<IPreparedStatement> statement = connection.prepareStatement(job.sql);
+                completion.updateCount = statement->executeBatch(job.params, job.columns, true);
+            }
+
+            if (savepoint)
+            {
+                conn->releaseSavepoint(savepoint.get());
+            }
+            else
+            {
+                connection.commit();
+            }
+        }
+        catch (const std::exception &e)
+        {
+            completion.success = false;
+            completion.error = e.what();
+
+            try
+            {
+                if (savepoint)
+                {
+                    conn->rollback(savepoint.get());
+                    conn->releaseSavepoint(savepoint.get());
+                }
+                else if (began)
+                {
+                    connection.rollback();
+                }
+            }
+            catch (const std::exception &rollbackError [[maybe_unused]])
+            {
+            }
+        }
+    }
+
+    bool AsyncExecutor::_runCursor(Stream &stream)
+    {
+        CursorBuffer &cursor = *stream.cursor;
+
+        try
+        {
+            // Closed while it was queued or parked
+            if (cursor.isClosed())
+            {
+                _releaseStream(stream, false);
+                return false;
+            }
+
+            if (!stream.resultSet)
+            {
+                auto connection = static_cast<sql::Connection *>(*stream.connection);
+                auto fetchSize = static_cast<std::int32_t>(cursor.getFetchSize());
+
+                // A fetch size makes the connector stream the rows instead of buffering the whole result
+                if (stream.params.empty())
+                {
+                    stream.statement.reset(connection->createStatement());
+                    stream.statement->setFetchSize(fetchSize);
+                    stream.resultSet.reset(stream.statement->executeQuery(stream.sql));
+                }
+                else
+                {
+                    stream.prepared = stream.connection->getStatementCache().acquire(stream.sql);
+                    bindParams(*stream.prepared, stream.params);
+                    stream.prepared->setFetchSize(fetchSize);
+                    stream.resultSet.reset(stream.prepared->executeQuery());
+                }
+
+                std::vector<std::string> columns;
+                readColumns(*stream.resultSet, columns, stream.types);
+                cursor.setColumns(columns, stream.types);
+            }
+
+            std::vector<Value> chunk;
+
+            while (true)
+            {
+                std::size_t rows = 0;
+                chunk.clear();
+
+                while (rows < cursor.getFetchSize() && stream.resultSet->next())
+                {
+                    readRow(*stream.resultSet, stream.types, chunk);
+                    rows++;
+                }
+
+                if (!cursor.push(chunk, rows))
+                {
+                    _releaseStream(stream, false);
+                    return false;
+                }
+
+                if (rows < cursor.getFetchSize())
+                {
+                    _releaseStream(stream, true);
+                    cursor.finish({});
+                    return false;
+                }
+
+                // The worker is free for other jobs until the cursor makes room
+                if (cursor.park())
+                {
+                    return true;
+                }
+            }
+        }
+        catch (const std::exception &e)
+        {
+            _releaseStream(stream, false);
+            cursor.finish(e.what());
+        }
+
+        return false;
+    }
+
+    void AsyncExecutor::_releaseStream(Stream &stream, bool reuse)
+    {
+        stream.resultSet.reset();
+        stream.statement.reset();
+
+        if (stream.prepared && reuse)
+        {
+            // Cached statements are shared with regular queries which expect buffered results
+            stream.prepared->setFetchSize(0);
+            stream.connection->getStatementCache().release(std::move(stream.sql), std::move(stream.prepared));
+        }
+
+        stream.prepared.reset();
+    }
+}
\ No newline at end of file
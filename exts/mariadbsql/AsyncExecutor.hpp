@@ -0,0 +1,104 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <IAsyncExecutor.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Luna::MDBSQL
+{
+    class Connection;
+    class CursorBuffer;
+
+    class AsyncExecutor final : public IAsyncExecutor
+    {
+    public:
+        AsyncExecutor();
+        ~AsyncExecutor() final;
+
+        void start(std::size_t workers) final;
+        void stop() final;
+        JobId submit(IConnection &connection, Kind kind, std::string_view sql, std::vector<Value> &&params) final;
+        JobId submitBatch(IConnection &connection, std::string_view sql, std::vector<Value> &&values,
+                          std::size_t columns) final;
+        std::unique_ptr<ICursor> openCursor(IConnection &connection, std::string_view sql, std::vector<Value> &&params,
+                                            std::size_t fetchSize, std::size_t maxBuffered) final;
+        void release(IConnection &connection) final;
+        void drain(IConnection &connection) final;
+        [[nodiscard]] bool isBusy(IConnection &connection) const final;
+        std::size_t poll(std::vector<Completion> &completions, std::size_t max) final;
+        Stats getStats() const final;
+
+        // Queues the next part of a parked cursor
+        void resumeCursor(const std::shared_ptr<CursorBuffer> &cursor);
+
+    private:
+        struct Job
+        {
+            JobId id;
+            Connection *connection;
+            Kind kind;
+            std::string sql;
+            std::vector<Value> params;
+            std::size_t columns;
+            std::shared_ptr<CursorBuffer> cursor;
+        };
+
+        // Query of a cursor kept open between its parts
+        struct Stream;
+
+    private:
+        void _work();
+        [[nodiscard]] bool _canRun(const Job &job) const;
+        [[nodiscard]] bool _isBusy(const Connection *connection) const;
+        [[nodiscard]] bool _hasJobs(const Connection *connection) const;
+        [[nodiscard]] Stream *_findStream(const Connection *connection) const;
+        [[nodiscard]] Stream *_findStream(const CursorBuffer *cursor) const;
+        Stream &_openStream(Job &job);
+        void _closeStream(const Stream &stream);
+        JobId _submit(Job &&job);
+        void _complete(Completion &&completion);
+        void _closeCursors(const Connection *connection);
+        static void _run(Job &job, Completion &completion);
+        static void _runBatch(Job &job, Completion &completion);
+        // Returns true when the stream was parked
+        static bool _runCursor(Stream &stream);
+        static void _releaseStream(Stream &stream, bool reuse);
+
+    private:
+        std::vector<std::thread> m_workers;
+        std::deque<Job> m_jobs;
+        std::vector<const Connection *> m_busy;
+        std::vector<std::unique_ptr<Stream>> m_streams;
+        mutable std::mutex m_jobsMutex;
+        std::condition_variable m_jobsCond;
+        std::condition_variable m_idleCond;
+        JobId m_nextId = 1;
+        bool m_stopping = false;
+
+        std::deque<Completion> m_completions;
+        mutable std::mutex m_completionsMutex;
+        std::uint64_t m_processed = 0;
+    };
+}
\ No newline at end of file
@@ -19,12 +19,55 @@
 
 #include "Connection.hpp"
 #include "PreparedStatement.hpp"
+#include "ConnectionPool.hpp"
+#include "StatementCache.hpp"
 
 #include <conncpp.hpp>
 
+#include <stdexcept>
+#include <utility>
+
 namespace Luna::MDBSQL
 {
-    Connection::Connection(nstd::observer_ptr<sql::Connection> connection) : m_connection(connection.get()) {}
+    Connection::Connection(nstd::observer_ptr<sql::Connection> connection, std::size_t cacheCapacity)
+        : m_connection(connection.get()),
+          m_statementCache(std::make_shared<StatementCache>(connection, cacheCapacity))
+    {
+    }
+
+    Connection::Connection(nstd::observer_ptr<sql::Connection> connection,
+                           std::shared_ptr<StatementCache> statementCache,
+                           nstd::observer_ptr<ConnectionPool> pool)
+        : m_connection(connection.get()),
+          m_statementCache(std::move(statementCache)),
+          m_pool(pool)
+    {
+    }
+
+    Connection::~Connection()
+    {
+        try
+        {
+            // Unfinished transaction is dropped, the ones already in the group are still committed
+            if (m_groupMember)
+            {
+                rollback();
+            }
+
+            flushGroupCommit(true);
+        }
+        catch (const std::exception &e [[maybe_unused]])
+        {
+        }
+
+        m_savepoints.clear();
+
+        // Leased connections go back to their pool instead of being closed, cached statements stay with them
+        if (m_pool)
+        {
+            m_pool->release(std::move(m_connection), std::move(m_statementCache));
+        }
+    }
 
     std::unique_ptr<IStatement> Connection::createStatement()
     {
@@ -33,6 +76,217 @@ namespace Luna::MDBSQL
 
     std::unique_ptr<IPreparedStatement> Connection::prepareStatement(std::string_view sql)
     {
-        return std::make_unique<PreparedStatement>(m_connection->prepareStatement(sql.data()));
+        return std::make_unique<PreparedStatement>(m_statementCache->acquire(sql).release(), m_statementCache, sql);
+    }
+
+    StatementCacheStats Connection::getStatementCacheStats()
+    {
+        return m_statementCache->getStats();
+    }
+
+    StatementCache &Connection::getStatementCache()
+    {
+        return *m_statementCache;
+    }
+
+    Connection::operator sql::Connection *()
+    {
+        return m_connection.get();
+    }
+
+    void Connection::setAutoCommit(bool autoCommit)
+    {
+        m_connection->setAutoCommit(autoCommit);
+    }
+
+    bool Connection::getAutoCommit()
+    {
+        return m_connection->getAutoCommit();
+    }
+
+    void Connection::begin()
+    {
+        if (m_groupWindow.count() == 0)
+        {
+            m_connection->setAutoCommit(false);
+            return;
+        }
+
+        if (m_groupMember)
+        {
+            throw std::logic_error("Transaction inside the commit group is still open");
+        }
+
+        if (!m_groupOpen)
+        {
+            m_connection->setAutoCommit(false);
+            m_groupStarted = std::chrono::steady_clock::now();
+            m_groupOpen = true;
+        }
+
+        m_groupMember.reset(m_connection->setSavepoint("luna_group_member"));
+        m_memberStarted = std::chrono::steady_clock::now();
+        m_memberExpired = false;
+    }
+
+    void Connection::commit()
+    {
+        m_savepoints.clear();
+
+        if (m_memberExpired)
+        {
+            m_memberExpired = false;
+            throw std::runtime_error("Transaction was rolled back for holding the commit group open too long");
+        }
+
+        if (m_groupOpen)
+        {
+            if (m_groupMember)
+            {
+                m_connection->releaseSavepoint(m_groupMember.get());
+                m_groupMember.reset();
+                m_groupCommitted++;
+            }
+
+            return;
+        }
+
+        m_connection->commit();
+        m_connection->setAutoCommit(true);
+    }
+
+    void Connection::rollback()
+    {
+        m_savepoints.clear();
+        m_memberExpired = false;
+
+        // Only undo this transaction, not the others waiting in the group
+        if (m_groupOpen)
+        {
+            if (m_groupMember)
+            {
+                m_connection->rollback(m_groupMember.get());
+                m_connection->releaseSavepoint(m_groupMember.get());
+                m_groupMember.reset();
+            }
+
+            return;
+        }
+
+        m_connection->rollback();
+        m_connection->setAutoCommit(true);
+    }
+
+    void Connection::setSavepoint(std::string_view name)
+    {
+        std::unique_ptr<sql::Savepoint> savepoint(m_connection->setSavepoint(std::string {name}.c_str()));
+
+        m_savepoints.insert_or_assign(std::string {name}, std::move(savepoint));
+    }
+
+    void Connection::releaseSavepoint(std::string_view name)
+    {
+        std::unique_ptr<sql::Savepoint> savepoint = _takeSavepoint(name);
+
+        m_connection->releaseSavepoint(savepoint.get());
+    }
+
+    void Connection::rollbackToSavepoint(std::string_view name)
+    {
+        auto it = m_savepoints.find(std::string {name});
+        if (it == m_savepoints.end())
+        {
+            throw std::invalid_argument("Unknown savepoint");
+        }
+
+        // Savepoint stays valid after rolling back to it
+        m_connection->rollback(it->second.get());
+    }
+
+    void Connection::setGroupCommit(std::uint32_t windowMs)
+    {
+        if (!windowMs)
+        {
+            // The group could not be committed anymore once the open transaction ends
+            if (m_groupMember)
+            {
+                throw std::logic_error("Transaction inside the commit group is still open");
+            }
+
+            flushGroupCommit(true);
+        }
+
+        m_groupWindow = std::chrono::milliseconds(windowMs);
+    }
+
+    bool Connection::flushGroupCommit(bool force)
+    {
+        if (!m_groupOpen)
+        {
+            return false;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+
+        if (m_groupMember)
+        {
+            // Wait for the transaction that is still inside the group
+            if (now - m_memberStarted < GROUP_MEMBER_TIMEOUT)
+            {
+                return false;
+            }
+
+            // It would hold everyone else's work and locks, its commit() reports the rollback
+            m_connection->rollback(m_groupMember.get());
+            m_connection->releaseSavepoint(m_groupMember.get());
+            m_groupMember.reset();
+            m_memberExpired = true;
+        }
+
+        if (!force && now - m_groupStarted < m_groupWindow)
+        {
+            return false;
+        }
+
+        std::size_t committed = std::exchange(m_groupCommitted, 0);
+        m_groupOpen = false;
+
+        try
+        {
+            m_connection->commit();
+        }
+        catch (const std::exception &e)
+        {
+            // Leave the connection in autocommit mode, otherwise later statements pile up in a transaction
+            try
+            {
+                m_connection->rollback();
+                m_connection->setAutoCommit(true);
+            }
+            catch (const std::exception &rollbackError [[maybe_unused]])
+            {
+            }
+
+            throw std::runtime_error("Group of " + std::to_string(committed) +
+                                     " transactions was rolled back: " + e.what());
+        }
+
+        m_connection->setAutoCommit(true);
+
+        return true;
+    }
+
+    std::unique_ptr<sql::Savepoint> Connection::_takeSavepoint(std::string_view name)
+    {
+        auto it = m_savepoints.find(std::string {name});
+        if (it == m_savepoints.end())
+        {
+            throw std::invalid_argument("Unknown savepoint");
+        }
+
+        std::unique_ptr<sql::Savepoint> savepoint = std::move(it->second);
+        m_savepoints.erase(it);
+
+        return savepoint;
     }
 }
\ No newline at end of file
@@ -23,23 +23,69 @@
 
 #include <anubis/observer_ptr.hpp>
 
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
 namespace sql
 {
     class Connection;
+    class Savepoint;
 }
 
 namespace Luna::MDBSQL
 {
+    class ConnectionPool;
+    class StatementCache;
+
     class Connection final : public IConnection
     {
     public:
-        explicit Connection(nstd::observer_ptr<sql::Connection> connection);
-        ~Connection() final = default;
+        Connection(nstd::observer_ptr<sql::Connection> connection, std::size_t cacheCapacity);
+        Connection(nstd::observer_ptr<sql::Connection> connection, std::shared_ptr<StatementCache> statementCache,
+                   nstd::observer_ptr<ConnectionPool> pool);
+        ~Connection() final;
 
         std::unique_ptr<IStatement> createStatement() final;
         std::unique_ptr<IPreparedStatement> prepareStatement(std::string_view sql) final;
+        StatementCacheStats getStatementCacheStats() final;
+
+        void setAutoCommit(bool autoCommit) final;
+        bool getAutoCommit() final;
+        void begin() final;
+        void commit() final;
+        void rollback() final;
+        void setSavepoint(std::string_view name) final;
+        void releaseSavepoint(std::string_view name) final;
+        void rollbackToSavepoint(std::string_view name) final;
+        void setGroupCommit(std::uint32_t windowMs) final;
+        bool flushGroupCommit(bool force) final;
+
+        StatementCache &getStatementCache();
+        explicit operator sql::Connection *();
+
+    private:
+        // Longest a transaction may hold the commit group open before it is rolled back
+        static constexpr std::chrono::seconds GROUP_MEMBER_TIMEOUT{1};
+
+    private:
+        std::unique_ptr<sql::Savepoint> _takeSavepoint(std::string_view name);
 
     private:
         std::unique_ptr<sql::Connection> m_connection;
+        // Declared after the connection so cached statements are closed first
+        std::shared_ptr<StatementCache> m_statementCache;
+        nstd::observer_ptr<ConnectionPool> m_pool;
+        std::unordered_map<std::string, std::unique_ptr<sql::Savepoint>> m_savepoints;
+
+        // Group commit, m_groupMember marks the small transaction currently inside the group
+        std::chrono::milliseconds m_groupWindow{};
+        std::chrono::steady_clock::time_point m_groupStarted;
+        std::chrono::steady_clock::time_point m_memberStarted;
+        std::unique_ptr<sql::Savepoint> m_groupMember;
+        std::size_t m_groupCommitted{};
+        bool m_groupOpen = false;
+        // Set when the member was rolled back for holding the group too long
+        bool m_memberExpired = false;
     };
 }
\ No newline at end of file
@@ -0,0 +1,182 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "ConnectionPool.hpp"
+#include "Connection.hpp"
+#include "StatementCache.hpp"
+
+#include <conncpp.hpp>
+
+namespace Luna::MDBSQL
+{
+    ConnectionPool::ConnectionPool(nstd::observer_ptr<sql::Driver> driver, const PoolConfig &config,
+                                   std::size_t cacheCapacity)
+        : m_driver(driver),
+          m_config(config),
+          m_cacheCapacity(cacheCapacity)
+    {
+        std::lock_guard lock(m_mutex);
+
+        // Open the minimum up front so the first leases do not pay for TCP and auth
+        while (m_idle.size() < m_config.minSize)
+        {
+            std::unique_ptr<sql::Connection> connection = _open();
+            if (!connection)
+            {
+                break;
+            }
+
+            auto statementCache = std::make_shared<StatementCache>(connection.get(), m_cacheCapacity);
+            m_idle.push_back({std::move(connection), std::move(statementCache), Clock::now()});
+        }
+    }
+
+    ConnectionPool::~ConnectionPool() = default;
+
+    std::unique_ptr<IConnection> ConnectionPool::acquire()
+    {
+        std::lock_guard lock(m_mutex);
+
+        _prune(Clock::now());
+
+        while (!m_idle.empty())
+        {
+            Idle idle = std::move(m_idle.back());
+            m_idle.pop_back();
+
+            bool valid = false;
+
+            try
+            {
+                valid = idle.connection->isValid(1);
+            }
+            catch (const std::exception &e [[maybe_unused]])
+            {
+            }
+
+            if (!valid)
+            {
+                m_discarded++;
+                continue;
+            }
+
+            m_reused++;
+
+            return _lease(std::move(idle));
+        }
+
+        if (m_leased >= m_config.maxSize)
+        {
+            return nullptr;
+        }
+
+        std::unique_ptr<sql::Connection> connection = _open();
+        if (!connection)
+        {
+            return nullptr;
+        }
+
+        auto statementCache = std::make_shared<StatementCache>(connection.get(), m_cacheCapacity);
+        return _lease({std::move(connection), std::move(statementCache), Clock::now()});
+    }
+
+    void ConnectionPool::release(std::unique_ptr<sql::Connection> &&connection,
+                                 std::shared_ptr<StatementCache> &&statementCache)
+    {
+        std::lock_guard lock(m_mutex);
+
+        m_leased--;
+
+        bool closed = true;
+
+        try
+        {
+            closed = connection->isClosed();
+
+            // Work left uncommitted by the previous lessee must not leak into the next one
+            if (!closed && !connection->getAutoCommit())
+            {
+                connection->rollback();
+                connection->setAutoCommit(true);
+            }
+        }
+        catch (const std::exception &e [[maybe_unused]])
+        {
+        }
+
+        if (closed)
+        {
+            m_discarded++;
+            return;
+        }
+
+        m_idle.push_back({std::move(connection), std::move(statementCache), Clock::now()});
+        _prune(Clock::now());
+    }
+
+    PoolStats ConnectionPool::getStats() const
+    {
+        std::lock_guard lock(m_mutex);
+
+        return {m_idle.size(), m_leased, m_created, m_reused, m_discarded};
+    }
+
+    std::unique_ptr<IConnection> ConnectionPool::_lease(Idle &&idle)
+    {
+        m_leased++;
+
+        return std::make_unique<Connection>(idle.connection.release(), std::move(idle.statementCache), this);
+    }
+
+    std::unique_ptr<sql::Connection> ConnectionPool::_open()
+    {
+        sql::Properties properties;
+        for (const auto &[key, value] : m_config.properties)
+        {
+            properties.emplace(key, value);
+        }
+
+        try
+        {
+            std::unique_ptr<sql::Connection> connection(m_driver->connect(m_config.url.c_str(), properties));
+
+            if (connection)
+            {
+                m_created++;
+            }
+
+            return connection;
+        }
+        catch (const std::exception &e [[maybe_unused]])
+        {
+            return nullptr;
+        }
+    }
+
+    void ConnectionPool::_prune(Clock::time_point now)
+    {
+        const auto timeout = std::chrono::seconds(m_config.idleTimeout);
+
+        // Oldest idle connections are at the front
+        while (!m_idle.empty() && m_idle.size() + m_leased > m_config.minSize && now - m_idle.front().since >= timeout)
+        {
+            m_idle.erase(m_idle.begin());
+            m_discarded++;
+        }
+    }
+}
\ No newline at end of file
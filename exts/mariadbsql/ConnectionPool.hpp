@@ -0,0 +1,78 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <IDriver.hpp>
+
+#include <anubis/observer_ptr.hpp>
+
+#include <chrono>
+#include <mutex>
+#include <vector>
+
+namespace sql
+{
+    class Connection;
+    class Driver;
+}
+
+namespace Luna::MDBSQL
+{
+    class StatementCache;
+
+    class ConnectionPool
+    {
+    public:
+        ConnectionPool(nstd::observer_ptr<sql::Driver> driver, const PoolConfig &config, std::size_t cacheCapacity);
+        ConnectionPool(const ConnectionPool &) = delete;
+        ConnectionPool &operator=(const ConnectionPool &) = delete;
+        ~ConnectionPool();
+
+        std::unique_ptr<IConnection> acquire();
+        void release(std::unique_ptr<sql::Connection> &&connection, std::shared_ptr<StatementCache> &&statementCache);
+        PoolStats getStats() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        struct Idle
+        {
+            std::unique_ptr<sql::Connection> connection;
+            std::shared_ptr<StatementCache> statementCache;
+            Clock::time_point since;
+        };
+
+    private:
+        std::unique_ptr<IConnection> _lease(Idle &&idle);
+        std::unique_ptr<sql::Connection> _open();
+        void _prune(Clock::time_point now);
+
+    private:
+        nstd::observer_ptr<sql::Driver> m_driver;
+        PoolConfig m_config;
+        std::size_t m_cacheCapacity;
+        // Most recently returned connection is at the back and gets reused first
+        std::vector<Idle> m_idle;
+        std::size_t m_leased{};
+        std::uint64_t m_created{};
+        std::uint64_t m_reused{};
+        std::uint64_t m_discarded{};
+        mutable std::mutex m_mutex;
+    };
+}
\ No newline at end of file
@@ -0,0 +1,195 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Cursor.hpp"
+#include "AsyncExecutor.hpp"
+
+#include <algorithm>
+#include <iterator>
+
+namespace Luna::MDBSQL
+{
+    CursorBuffer::CursorBuffer(std::size_t fetchSize, std::size_t maxBuffered)
+        : m_fetchSize(std::max<std::size_t>(fetchSize, 1)),
+          m_maxBuffered(std::max(maxBuffered, m_fetchSize))
+    {
+    }
+
+    void CursorBuffer::setColumns(const std::vector<std::string> &columns, const std::vector<ColumnType> &types)
+    {
+        std::lock_guard lock(m_mutex);
+
+        m_columns = columns;
+        m_types = types;
+    }
+
+    bool CursorBuffer::push(std::vector<Value> &values, std::size_t rows)
+    {
+        std::lock_guard lock(m_mutex);
+
+        if (m_closed)
+        {
+            return false;
+        }
+
+        std::move(values.begin(), values.end(), std::back_inserter(m_values));
+        m_buffered += rows;
+        m_fetched += rows;
+
+        return true;
+    }
+
+    bool CursorBuffer::park()
+    {
+        std::lock_guard lock(m_mutex);
+
+        m_parked = !m_closed && m_buffered + m_fetchSize > m_maxBuffered;
+
+        return m_parked;
+    }
+
+    void CursorBuffer::finish(std::string &&error)
+    {
+        std::lock_guard lock(m_mutex);
+
+        m_error = std::move(error);
+        m_finished = true;
+    }
+
+    std::size_t CursorBuffer::take(Rows &rows, std::size_t max, bool &resume)
+    {
+        std::lock_guard lock(m_mutex);
+
+        std::size_t count = max ? std::min(max, m_buffered) : m_buffered;
+
+        rows.columns = m_columns;
+        rows.types = m_types;
+        rows.values.clear();
+
+        auto end = m_values.begin() + static_cast<std::ptrdiff_t>(count * m_columns.size());
+        std::move(m_values.begin(), end, std::back_inserter(rows.values));
+        m_values.erase(m_values.begin(), end);
+
+        m_buffered -= count;
+        m_taken += count;
+
+        resume = m_parked && m_buffered + m_fetchSize <= m_maxBuffered;
+
+        if (resume)
+        {
+            m_parked = false;
+        }
+
+        return count;
+    }
+
+    bool CursorBuffer::close()
+    {
+        std::lock_guard lock(m_mutex);
+
+        bool parked = m_parked;
+
+        m_closed = true;
+        m_parked = false;
+        m_values.clear();
+        m_buffered = 0;
+
+        return parked;
+    }
+
+    bool CursorBuffer::isDone() const
+    {
+        std::lock_guard lock(m_mutex);
+
+        return m_closed || (m_finished && !m_buffered);
+    }
+
+    bool CursorBuffer::isClosed() const
+    {
+        std::lock_guard lock(m_mutex);
+
+        return m_closed;
+    }
+
+    std::string CursorBuffer::getError() const
+    {
+        std::lock_guard lock(m_mutex);
+
+        return m_error;
+    }
+
+    ICursor::Stats CursorBuffer::getStats() const
+    {
+        std::lock_guard lock(m_mutex);
+
+        return {m_buffered, m_fetched, m_taken};
+    }
+
+    std::size_t CursorBuffer::getFetchSize() const
+    {
+        return m_fetchSize;
+    }
+
+    Cursor::Cursor(std::shared_ptr<CursorBuffer> buffer, AsyncExecutor &executor)
+        : m_buffer(std::move(buffer)),
+          m_executor(executor)
+    {
+    }
+
+    Cursor::~Cursor()
+    {
+        // A parked stream still holds the connection
+        close();
+    }
+
+    std::size_t Cursor::take(Rows &rows, std::size_t max)
+    {
+        bool resume;
+        std::size_t count = m_buffer->take(rows, max, resume);
+
+        if (resume)
+        {
+            m_executor.resumeCursor(m_buffer);
+        }
+
+        return count;
+    }
+
+    bool Cursor::isDone() const
+    {
+        return m_buffer->isDone();
+    }
+
+    std::string Cursor::getError() const
+    {
+        return m_buffer->getError();
+    }
+
+    void Cursor::close()
+    {
+        if (m_buffer->close())
+        {
+            m_executor.resumeCursor(m_buffer);
+        }
+    }
+
+    ICursor::Stats Cursor::getStats() const
+    {
+        return m_buffer->getStats();
+    }
+}
\ No newline at end of file
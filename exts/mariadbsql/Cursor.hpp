@@ -0,0 +1,94 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <ICursor.hpp>
+
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Luna::MDBSQL
+{
+    class AsyncExecutor;
+
+    /**
+     * @brief Rows shared between the worker streaming a query and its cursor.
+     *
+     * Once the buffer is full the stream is parked and the worker goes back to
+     * other jobs. Taking enough rows or closing the cursor asks the executor
+     * to continue it.
+     */
+    class CursorBuffer
+    {
+    public:
+        CursorBuffer(std::size_t fetchSize, std::size_t maxBuffered);
+
+        // Worker side
+        void setColumns(const std::vector<std::string> &columns, const std::vector<ColumnType> &types);
+        // Returns false once the cursor was closed
+        bool push(std::vector<Value> &values, std::size_t rows);
+        // Parks the stream when the next chunk would not fit
+        [[nodiscard]] bool park();
+        void finish(std::string &&error);
+
+        // Cursor side, resume is set when the parked stream has to be continued
+        std::size_t take(Rows &rows, std::size_t max, bool &resume);
+        // Returns true when the stream was parked and has to be continued to clean up
+        bool close();
+        [[nodiscard]] bool isDone() const;
+        [[nodiscard]] bool isClosed() const;
+        [[nodiscard]] std::string getError() const;
+        [[nodiscard]] ICursor::Stats getStats() const;
+        [[nodiscard]] std::size_t getFetchSize() const;
+
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<std::string> m_columns;
+        std::vector<ColumnType> m_types;
+        std::deque<Value> m_values;
+        std::size_t m_buffered{};
+        std::size_t m_fetchSize;
+        std::size_t m_maxBuffered;
+        std::uint64_t m_fetched{};
+        std::uint64_t m_taken{};
+        std::string m_error;
+        bool m_finished = false;
+        bool m_closed = false;
+        bool m_parked = false;
+    };
+
+    class Cursor final : public ICursor
+    {
+    public:
+        Cursor(std::shared_ptr<CursorBuffer> buffer, AsyncExecutor &executor);
+        ~Cursor() final;
+
+        std::size_t take(Rows &rows, std::size_t max) final;
+        bool isDone() const final;
+        std::string getError() const final;
+        void close() final;
+        Stats getStats() const final;
+
+    private:
+        std::shared_ptr<CursorBuffer> m_buffer;
+        AsyncExecutor &m_executor;
+    };
+}
\ No newline at end of file
@@ -34,12 +34,13 @@ namespace Luna::MDBSQL
                sqlProps.emplace(key, value);
            }
 
-           return std::make_unique<Connection>(m_sqlDriver->connect(url.data(), sqlProps));
+           return std::make_unique<Connection>(m_sqlDriver->connect(url.data(), sqlProps), m_statementCacheSize);
        }
 
        std::unique_ptr<IConnection> Driver::connect(std::string_view host, std::string_view user, std::string_view pwd)
        {
-           return std::make_unique<Connection>(m_sqlDriver->connect(host.data(), user.data(), pwd.data()));
+           return std::make_unique<Connection>(m_sqlDriver->connect(host.data(), user.data(), pwd.data()),
+                                              m_statementCacheSize);
        }
 
        std::unique_ptr<IConnection> Driver::connect(const Properties &props)
@@ -50,7 +51,7 @@ namespace Luna::MDBSQL
                sqlProps.emplace(key, value);
            }
 
-           return std::make_unique<Connection>(m_sqlDriver->connect(sqlProps));
+           return std::make_unique<Connection>(m_sqlDriver->connect(sqlProps), m_statementCacheSize);
        }
 
        bool Driver::acceptsURL(std::string_view url)
@@ -77,4 +78,47 @@ namespace Luna::MDBSQL
        {
            return m_sqlDriver->getName().c_str();
        }
+
+       IAsyncExecutor &Driver::getAsyncExecutor()
+       {
+           return m_asyncExecutor;
+       }
+
+       void Driver::setStatementCacheSize(std::size_t size)
+       {
+           m_statementCacheSize = size;
+       }
+
+       bool Driver::createPool(std::string_view name, const PoolConfig &config)
+       {
+           if (m_pools.find(std::string {name}) != m_pools.end())
+           {
+               return false;
+           }
+
+           m_pools.emplace(name, std::make_unique<ConnectionPool>(m_sqlDriver, config, m_statementCacheSize));
+           return true;
+       }
+
+       std::unique_ptr<IConnection> Driver::acquire(std::string_view name)
+       {
+           auto it = m_pools.find(std::string {name});
+           if (it == m_pools.end())
+           {
+               return nullptr;
+           }
+
+           return it->second->acquire();
+       }
+
+       PoolStats Driver::getPoolStats(std::string_view name)
+       {
+           auto it = m_pools.find(std::string {name});
+           if (it == m_pools.end())
+           {
+               return {};
+           }
+
+           return it->second->getStats();
+       }
 }
\ No newline at end of file
@@ -20,9 +20,13 @@
 #pragma once
 
 #include <IDriver.hpp>
+#include "AsyncExecutor.hpp"
+#include "ConnectionPool.hpp"
 
 #include <anubis/observer_ptr.hpp>
 
+#include <unordered_map>
+
 namespace sql
 {
     class Driver;
@@ -44,8 +48,16 @@ namespace Luna::MDBSQL
        uint32_t getMinorVersion() final;
        bool jdbcCompliant() final;
        std::string_view getName() final;
+       IAsyncExecutor &getAsyncExecutor() final;
+       void setStatementCacheSize(std::size_t size) final;
+       bool createPool(std::string_view name, const PoolConfig &config) final;
+       std::unique_ptr<IConnection> acquire(std::string_view name) final;
+       PoolStats getPoolStats(std::string_view name) final;
 
    private:
        nstd::observer_ptr<sql::Driver> m_sqlDriver;
+       AsyncExecutor m_asyncExecutor;
+       std::size_t m_statementCacheSize = 32;
+       std::unordered_map<std::string, std::unique_ptr<ConnectionPool>> m_pools;
    };
 }
\ No newline at end of file
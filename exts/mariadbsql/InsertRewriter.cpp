@@ -0,0 +1,216 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "InsertRewriter.hpp"
+
+#include <cctype>
+
+namespace
+{
+    bool isQuote(char c)
+    {
+        return c == '\'' || c == '"' || c == '`';
+    }
+
+    bool isWordChar(char c)
+    {
+        return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+    }
+
+    bool matchesKeyword(std::string_view sql, std::size_t pos, std::string_view keyword)
+    {
+        if (sql.length() - pos < keyword.length())
+        {
+            return false;
+        }
+
+        for (std::size_t i = 0; i < keyword.length(); i++)
+        {
+            if (std::toupper(static_cast<unsigned char>(sql[pos + i])) != keyword[i])
+            {
+                return false;
+            }
+        }
+
+        std::size_t end = pos + keyword.length();
+        return (!pos || !isWordChar(sql[pos - 1])) && (end == sql.length() || !isWordChar(sql[end]));
+    }
+
+    // Returns the position after the quoted string starting at pos
+    std::size_t skipQuoted(std::string_view sql, std::size_t pos)
+    {
+        char quote = sql[pos++];
+
+        while (pos < sql.length())
+        {
+            if (sql[pos] == '\\' && quote != '`')
+            {
+                pos += 2;
+                continue;
+            }
+
+            if (sql[pos++] == quote)
+            {
+                // Doubled quote is an escaped quote
+                if (pos < sql.length() && sql[pos] == quote)
+                {
+                    pos++;
+                    continue;
+                }
+
+                return pos;
+            }
+        }
+
+        return std::string_view::npos;
+    }
+}
+
+namespace Luna::MDBSQL
+{
+    std::optional<InsertTemplate> parseInsert(std::string_view sql)
+    {
+        std::size_t pos = 0;
+
+        while (pos < sql.length() && std::isspace(static_cast<unsigned char>(sql[pos])))
+        {
+            pos++;
+        }
+
+        if (!matchesKeyword(sql, pos, "INSERT") && !matchesKeyword(sql, pos, "REPLACE"))
+        {
+            return std::nullopt;
+        }
+
+        // Find VALUES outside of quoted identifiers and strings
+        std::size_t values = std::string_view::npos;
+
+        while (pos < sql.length())
+        {
+            if (isQuote(sql[pos]))
+            {
+                pos = skipQuoted(sql, pos);
+                if (pos == std::string_view::npos)
+                {
+                    return std::nullopt;
+                }
+
+                continue;
+            }
+
+            if (matchesKeyword(sql, pos, "VALUES"))
+            {
+                values = pos;
+                break;
+            }
+
+            pos++;
+        }
+
+        if (values == std::string_view::npos)
+        {
+            return std::nullopt;
+        }
+
+        pos = values + 6;
+        while (pos < sql.length() && std::isspace(static_cast<unsigned char>(sql[pos])))
+        {
+            pos++;
+        }
+
+        if (pos == sql.length() || sql[pos] != '(')
+        {
+            return std::nullopt;
+        }
+
+        std::size_t groupStart = pos;
+        std::size_t depth = 0;
+        std::size_t placeholders = 0;
+
+        while (pos < sql.length())
+        {
+            char c = sql[pos];
+
+            if (isQuote(c))
+            {
+                pos = skipQuoted(sql, pos);
+                if (pos == std::string_view::npos)
+                {
+                    return std::nullopt;
+                }
+
+                continue;
+            }
+
+            pos++;
+
+            if (c == '?')
+            {
+                placeholders++;
+            }
+            else if (c == '(')
+            {
+                depth++;
+            }
+            else if (c == ')' && !--depth)
+            {
+                break;
+            }
+        }
+
+        if (depth || !placeholders)
+        {
+            return std::nullopt;
+        }
+
+        std::string_view tail = sql.substr(pos);
+
+        // Already a multi-row INSERT
+        if (std::size_t next = tail.find_first_not_of(" \t\r\n"); next != std::string_view::npos && tail[next] == ',')
+        {
+            return std::nullopt;
+        }
+
+        return InsertTemplate {std::string {sql.substr(0, groupStart)},
+                               std::string {sql.substr(groupStart, pos - groupStart)},
+                               std::string {tail},
+                               placeholders};
+    }
+
+    std::string buildInsert(const InsertTemplate &insert, std::size_t rows)
+    {
+        std::string sql;
+        sql.reserve(insert.head.length() + (insert.group.length() + 2) * rows + insert.tail.length());
+
+        sql.append(insert.head);
+
+        for (std::size_t i = 0; i < rows; i++)
+        {
+            if (i)
+            {
+                sql.append(", ");
+            }
+
+            sql.append(insert.group);
+        }
+
+        sql.append(insert.tail);
+
+        return sql;
+    }
+}
\ No newline at end of file
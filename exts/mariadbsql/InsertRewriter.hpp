@@ -0,0 +1,44 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cinttypes>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace Luna::MDBSQL
+{
+    /**
+     * @brief Single-row INSERT split around its VALUES group.
+     *
+     * Repeating the group turns the statement into a multi-row INSERT so a
+     * batch is sent as one statement instead of one per row.
+     */
+    struct InsertTemplate
+    {
+        std::string head;
+        std::string group;
+        std::string tail;
+        std::size_t placeholders;
+    };
+
+    [[nodiscard]] std::optional<InsertTemplate> parseInsert(std::string_view sql);
+    [[nodiscard]] std::string buildInsert(const InsertTemplate &insert, std::size_t rows);
+}
\ No newline at end of file
@@ -19,8 +19,12 @@
 
 #include "PreparedStatement.hpp"
 #include "ResultSet.hpp"
+#include "StatementCache.hpp"
+#include "InsertRewriter.hpp"
+#include "RowReader.hpp"
 
 #include <conncpp.hpp>
+#include <algorithm>
 #include <cstddef>
 
 namespace Luna::MDBSQL
@@ -28,6 +32,29 @@ namespace Luna::MDBSQL
     PreparedStatement::PreparedStatement(nstd::observer_ptr<sql::PreparedStatement> preparedStmt)
     : Statement(preparedStmt.get()) {}
 
+    PreparedStatement::PreparedStatement(nstd::observer_ptr<sql::PreparedStatement> preparedStmt,
+                                         std::weak_ptr<StatementCache> cache,
+                                         std::string_view sql)
+        : Statement(preparedStmt.get()),
+          m_cache(std::move(cache)),
+          m_sql(sql)
+    {
+    }
+
+    PreparedStatement::~PreparedStatement()
+    {
+        std::shared_ptr<StatementCache> cache = m_cache.lock();
+        if (!cache)
+        {
+            return;
+        }
+
+        std::unique_ptr<sql::PreparedStatement> statement(operator sql::PreparedStatement *());
+        m_statement.release();
+
+        cache->release(std::move(m_sql), std::move(statement));
+    }
+
     bool PreparedStatement::execute()
     {
         return operator sql::PreparedStatement *()->execute();
@@ -128,6 +155,79 @@ namespace Luna::MDBSQL
         operator sql::PreparedStatement *()->setBigInt(parameterIndex, value.data());
     }
 
+    int64_t PreparedStatement::executeBatch(const std::vector<Value> &values, std::size_t columns, bool rewrite)
+    {
+        if (!columns || values.size() < columns)
+        {
+            return 0;
+        }
+
+        std::size_t rows = values.size() / columns;
+
+        if (rewrite && rows > 1)
+        {
+            std::shared_ptr<StatementCache> cache = m_cache.lock();
+            std::optional<InsertTemplate> insert = parseInsert(m_sql);
+
+            if (cache && insert && insert->placeholders == columns)
+            {
+                return _executeRewritten(*cache, *insert, values, columns);
+            }
+        }
+
+        auto statement = operator sql::PreparedStatement *();
+        statement->clearBatch();
+
+        for (std::size_t row = 0; row < rows; row++)
+        {
+            bindParams(*statement, values.data() + row * columns, columns);
+            statement->addBatch();
+        }
+
+        int64_t affected = 0;
+
+        // Negative counts are SUCCESS_NO_INFO or EXECUTE_FAILED
+        for (int64_t count : statement->executeLargeBatch())
+        {
+            affected += std::max<int64_t>(count, 0);
+        }
+
+        statement->clearBatch();
+        return affected;
+    }
+
+    int64_t PreparedStatement::_executeRewritten(StatementCache &cache, const InsertTemplate &insert,
+                                                 const std::vector<Value> &values, std::size_t columns)
+    {
+        std::size_t rows = values.size() / columns;
+        std::size_t chunk = std::max<std::size_t>(MAX_PLACEHOLDERS / columns, 1);
+        int64_t affected = 0;
+
+        // Full chunks share one cached statement, the remainder's size varies between calls so it is not cached
+        for (std::size_t row = 0; row < rows; row += chunk)
+        {
+            std::size_t count = std::min(chunk, rows - row);
+            std::string sql = buildInsert(insert, count);
+
+            bool full = count == chunk;
+
+            std::unique_ptr<sql::PreparedStatement> statement = full ? cache.acquire(sql) : cache.prepare(sql);
+            bindParams(*statement, values.data() + row * columns, count * columns);
+            affected += statement->executeLargeUpdate();
+
+            if (full)
+            {
+                cache.release(std::move(sql), std::move(statement));
+            }
+            else
+            {
+                statement->close();
+            }
+        }
+
+        return affected;
+    }
+
     PreparedStatement::operator sql::PreparedStatement *()
     {
         return dynamic_cast<sql::PreparedStatement *>(m_statement.get());
@@ -22,6 +22,8 @@
 #include <IPreparedStatement.hpp>
 #include "Statement.hpp"
 
+#include <string>
+
 namespace sql
 {
     class PreparedStatement;
@@ -29,11 +31,17 @@ namespace sql
 
 namespace Luna::MDBSQL
 {
+    class StatementCache;
+    struct InsertTemplate;
+
     class PreparedStatement final : public Statement, public virtual IPreparedStatement
     {
     public:
         explicit PreparedStatement(nstd::observer_ptr<sql::PreparedStatement> preparedStmt);
-        ~PreparedStatement() final = default;
+        PreparedStatement(nstd::observer_ptr<sql::PreparedStatement> preparedStmt,
+                          std::weak_ptr<StatementCache> cache,
+                          std::string_view sql);
+        ~PreparedStatement() final;
 
         bool execute() final;
         bool execute(std::string_view sql) final;
@@ -61,7 +69,20 @@ namespace Luna::MDBSQL
         void setDouble(int32_t parameterIndex, double value) final;
         void setBigInt(int32_t parameterIndex, std::string_view value) final;
 
+        int64_t executeBatch(const std::vector<Value> &values, std::size_t columns, bool rewrite) final;
+
+    private:
+        // Largest number of placeholders a single statement may have
+        static constexpr std::size_t MAX_PLACEHOLDERS = 65535;
+
     private:
         explicit operator sql::PreparedStatement *();
+        int64_t _executeRewritten(StatementCache &cache, const InsertTemplate &insert,
+                                  const std::vector<Value> &values, std::size_t columns);
+
+    private:
+        // Connection may be gone by the time the statement is destroyed
+        std::weak_ptr<StatementCache> m_cache;
+        std::string m_sql;
     };
 }
\ No newline at end of file
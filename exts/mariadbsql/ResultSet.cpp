@@ -20,6 +20,7 @@
 #include "ResultSet.hpp"
 #include "Statement.hpp"
 #include "Warning.hpp"
+#include "RowReader.hpp"
 
 #include <conncpp.hpp>
 
@@ -27,7 +28,21 @@ namespace Luna::MDBSQL
 {
     ResultSet::ResultSet(nstd::observer_ptr<sql::ResultSet> resultSet)
         : m_resultSet(resultSet.get())
-    {}
+    {
+        if (!m_resultSet)
+        {
+            return;
+        }
+
+        readColumns(*m_resultSet, m_columns, m_types);
+
+        // Keys view into m_columns, which is not modified past this point
+        m_columnIndexes.reserve(m_columns.size());
+        for (std::size_t i = 0; i < m_columns.size(); i++)
+        {
+            m_columnIndexes.try_emplace(m_columns[i], static_cast<std::int32_t>(i + 1));
+        }
+    }
 
     void ResultSet::close()
     {
@@ -136,7 +151,7 @@ namespace Luna::MDBSQL
 
     bool ResultSet::isNull(std::string_view columnLabel) const
     {
-        return m_resultSet->isNull(columnLabel.data());
+        return m_resultSet->isNull(_findColumn(columnLabel));
     }
 
     std::string ResultSet::getString(std::int32_t columnIndex) const
@@ -146,7 +161,7 @@ namespace Luna::MDBSQL
 
     std::string ResultSet::getString(std::string_view columnLabel) const
     {
-        return m_resultSet->getString(columnLabel.data()).c_str();
+        return m_resultSet->getString(_findColumn(columnLabel)).c_str();
     }
 
     std::int32_t ResultSet::getInt(std::int32_t columnIndex) const
@@ -156,7 +171,7 @@ namespace Luna::MDBSQL
 
     std::int32_t ResultSet::getInt(std::string_view columnLabel) const
     {
-        return m_resultSet->getInt(columnLabel.data());
+        return m_resultSet->getInt(_findColumn(columnLabel));
     }
 
     std::uint32_t ResultSet::getUInt(std::int32_t columnIndex) const
@@ -166,12 +181,12 @@ namespace Luna::MDBSQL
 
     std::uint32_t ResultSet::getUInt(std::string_view columnLabel) const
     {
-        return m_resultSet->getUInt(columnLabel.data());
+        return m_resultSet->getUInt(_findColumn(columnLabel));
     }
 
     std::int64_t ResultSet::getLong(std::string_view columnLabel) const
     {
-        return m_resultSet->getLong(columnLabel.data());
+        return m_resultSet->getLong(_findColumn(columnLabel));
     }
 
     std::int64_t ResultSet::getLong(std::int32_t columnIndex) const
@@ -181,7 +196,7 @@ namespace Luna::MDBSQL
 
     std::int64_t ResultSet::getInt64(std::string_view columnLabel) const
     {
-        return m_resultSet->getInt64(columnLabel.data());
+        return m_resultSet->getInt64(_findColumn(columnLabel));
     }
 
     std::int64_t ResultSet::getInt64(std::int32_t columnIndex) const
@@ -191,7 +206,7 @@ namespace Luna::MDBSQL
 
     std::uint64_t ResultSet::getUInt64(std::string_view columnLabel) const
     {
-        return m_resultSet->getUInt64(columnLabel.data());
+        return m_resultSet->getUInt64(_findColumn(columnLabel));
     }
 
     std::uint64_t ResultSet::getUInt64(std::int32_t columnIndex) const
@@ -201,7 +216,7 @@ namespace Luna::MDBSQL
 
     float ResultSet::getFloat(std::string_view columnLabel) const
     {
-        return m_resultSet->getFloat(columnLabel.data());
+        return m_resultSet->getFloat(_findColumn(columnLabel));
     }
 
     float ResultSet::getFloat(std::int32_t columnIndex) const
@@ -211,7 +226,7 @@ namespace Luna::MDBSQL
 
     long double ResultSet::getDouble(std::string_view columnLabel) const
     {
-        return m_resultSet->getDouble(columnLabel.data());
+        return m_resultSet->getDouble(_findColumn(columnLabel));
     }
 
     long double ResultSet::getDouble(std::int32_t columnIndex) const
@@ -226,7 +241,7 @@ namespace Luna::MDBSQL
 
     bool ResultSet::getBoolean(std::string_view columnLabel) const
     {
-        return m_resultSet->getBoolean(columnLabel.data());
+        return m_resultSet->getBoolean(_findColumn(columnLabel));
     }
 
     std::byte ResultSet::getByte(std::int32_t index) const
@@ -236,7 +251,7 @@ namespace Luna::MDBSQL
 
     std::byte ResultSet::getByte(std::string_view columnLabel) const
     {
-        return std::byte(m_resultSet->getByte(columnLabel.data()));
+        return std::byte(m_resultSet->getByte(_findColumn(columnLabel)));
     }
 
     std::int16_t ResultSet::getShort(std::int32_t index) const
@@ -246,11 +261,49 @@ namespace Luna::MDBSQL
 
     std::int16_t ResultSet::getShort(std::string_view columnLabel) const
     {
-        return m_resultSet->getShort(columnLabel.data());
+        return m_resultSet->getShort(_findColumn(columnLabel));
     }
 
     std::int32_t ResultSet::findColumn(std::string_view columnLabel) const
     {
+        return _findColumn(columnLabel);
+    }
+
+    std::size_t ResultSet::fetch(Rows &rows, std::size_t max)
+    {
+        rows.columns = m_columns;
+        rows.types = m_types;
+        rows.values.clear();
+
+        std::size_t count = 0;
+
+        while ((!max || count < max) && m_resultSet->next())
+        {
+            readRow(*m_resultSet, m_types, rows.values);
+            count++;
+        }
+
+        return count;
+    }
+
+    const std::vector<std::string> &ResultSet::getColumnNames() const
+    {
+        return m_columns;
+    }
+
+    const std::vector<ColumnType> &ResultSet::getColumnTypes() const
+    {
+        return m_types;
+    }
+
+    std::int32_t ResultSet::_findColumn(std::string_view columnLabel) const
+    {
+        if (auto it = m_columnIndexes.find(columnLabel); it != m_columnIndexes.end())
+        {
+            return it->second;
+        }
+
+        // Let the connector resolve anything else, it also raises the error for unknown labels
         return m_resultSet->findColumn(columnLabel.data());
     }
 }
\ No newline at end of file
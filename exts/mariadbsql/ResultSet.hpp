@@ -23,6 +23,9 @@
 
 #include <anubis/observer_ptr.hpp>
 
+#include <unordered_map>
+#include <vector>
+
 namespace sql
 {
     class ResultSet;
@@ -89,7 +92,18 @@ namespace Luna::MDBSQL
 
         std::int32_t findColumn(std::string_view columnLabel) const final;
 
+        std::size_t fetch(Rows &rows, std::size_t max) final;
+        const std::vector<std::string> &getColumnNames() const final;
+        const std::vector<ColumnType> &getColumnTypes() const final;
+
+    private:
+        [[nodiscard]] std::int32_t _findColumn(std::string_view columnLabel) const;
+
     private:
         std::unique_ptr<sql::ResultSet> m_resultSet;
+        // Column metadata is read once, by-name getters resolve labels through m_columnIndexes
+        std::vector<std::string> m_columns;
+        std::vector<ColumnType> m_types;
+        std::unordered_map<std::string_view, std::int32_t> m_columnIndexes;
     };
 }
\ No newline at end of file
@@ -0,0 +1,168 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "RowReader.hpp"
+
+#include <conncpp.hpp>
+
+#include <memory>
+#include <type_traits>
+
+namespace Luna::MDBSQL
+{
+    ColumnType toColumnType(std::string_view typeName)
+    {
+        // Unsigned types are reported as "<TYPE> UNSIGNED"
+        auto startsWith = [typeName](std::string_view prefix)
+        {
+            return typeName.substr(0, prefix.length()) == prefix;
+        };
+
+        if (startsWith("BOOL") || typeName == "BIT")
+        {
+            return ColumnType::Bool;
+        }
+
+        // Values above INT64_MAX would not fit, they are passed on as decimal strings
+        if (startsWith("BIGINT") && typeName.find("UNSIGNED") != std::string_view::npos)
+        {
+            return ColumnType::String;
+        }
+
+        if (startsWith("TINYINT") || startsWith("SMALLINT") || startsWith("MEDIUMINT") || startsWith("INT") ||
+            startsWith("BIGINT") || startsWith("YEAR"))
+        {
+            return ColumnType::Integer;
+        }
+
+        if (startsWith("FLOAT") || startsWith("DOUBLE") || startsWith("REAL") || startsWith("DECIMAL") ||
+            startsWith("NUMERIC"))
+        {
+            return ColumnType::Float;
+        }
+
+        if (typeName == "NULL")
+        {
+            return ColumnType::Null;
+        }
+
+        return ColumnType::String;
+    }
+
+    void readColumns(sql::ResultSet &resultSet, std::vector<std::string> &columns, std::vector<ColumnType> &types)
+    {
+        std::unique_ptr<sql::ResultSetMetaData> metaData(resultSet.getMetaData());
+        std::uint32_t count = metaData->getColumnCount();
+
+        columns.clear();
+        types.clear();
+
+        for (std::uint32_t i = 1; i <= count; i++)
+        {
+            columns.emplace_back(metaData->getColumnLabel(i).c_str());
+            types.push_back(toColumnType(metaData->getColumnTypeName(i).c_str()));
+        }
+    }
+
+    void readRow(sql::ResultSet &resultSet, const std::vector<ColumnType> &types, std::vector<Value> &values)
+    {
+        auto count = static_cast<std::int32_t>(types.size());
+
+        for (std::int32_t column = 1; column <= count; column++)
+        {
+            if (resultSet.isNull(column))
+            {
+                values.emplace_back();
+                continue;
+            }
+
+            switch (types[static_cast<std::size_t>(column - 1)])
+            {
+                case ColumnType::Null:
+                    values.emplace_back();
+                    break;
+                case ColumnType::Bool:
+                    values.emplace_back(resultSet.getBoolean(column));
+                    break;
+                case ColumnType::Integer:
+                    values.emplace_back(resultSet.getInt64(column));
+                    break;
+                case ColumnType::Float:
+                    values.emplace_back(static_cast<double>(resultSet.getDouble(column)));
+                    break;
+                case ColumnType::String:
+                    values.emplace_back(std::string {resultSet.getString(column).c_str()});
+                    break;
+            }
+        }
+    }
+
+    void readRows(sql::ResultSet &resultSet, Rows &rows)
+    {
+        readColumns(resultSet, rows.columns, rows.types);
+        rows.values.clear();
+
+        while (resultSet.next())
+        {
+            readRow(resultSet, rows.types, rows.values);
+        }
+    }
+
+    void bindParams(sql::PreparedStatement &statement, const std::vector<Value> &params)
+    {
+        bindParams(statement, params.data(), params.size());
+    }
+
+    void bindParams(sql::PreparedStatement &statement, const Value *params, std::size_t count)
+    {
+        std::int32_t index = 1;
+
+        for (const Value *param = params; param != params + count; param++)
+        {
+            std::visit(
+                [&statement, index](const auto &value)
+                {
+                    using T = std::decay_t<decltype(value)>;
+
+                    if constexpr (std::is_same_v<T, std::monostate>)
+                    {
+                        statement.setNull(index, 0);
+                    }
+                    else if constexpr (std::is_same_v<T, bool>)
+                    {
+                        statement.setBoolean(index, value);
+                    }
+                    else if constexpr (std::is_same_v<T, std::int64_t>)
+                    {
+                        statement.setLong(index, value);
+                    }
+                    else if constexpr (std::is_same_v<T, double>)
+                    {
+                        statement.setDouble(index, value);
+                    }
+                    else
+                    {
+                        statement.setString(index, value);
+                    }
+                },
+                *param);
+
+            index++;
+        }
+    }
+}
\ No newline at end of file
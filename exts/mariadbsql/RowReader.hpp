@@ -0,0 +1,40 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <Value.hpp>
+
+#include <string_view>
+#include <vector>
+
+namespace sql
+{
+    class ResultSet;
+    class PreparedStatement;
+}
+
+namespace Luna::MDBSQL
+{
+    [[nodiscard]] ColumnType toColumnType(std::string_view typeName);
+    void readColumns(sql::ResultSet &resultSet, std::vector<std::string> &columns, std::vector<ColumnType> &types);
+    void readRow(sql::ResultSet &resultSet, const std::vector<ColumnType> &types, std::vector<Value> &values);
+    void readRows(sql::ResultSet &resultSet, Rows &rows);
+    void bindParams(sql::PreparedStatement &statement, const std::vector<Value> &params);
+    void bindParams(sql::PreparedStatement &statement, const Value *params, std::size_t count);
+}
\ No newline at end of file
@@ -0,0 +1,109 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "StatementCache.hpp"
+
+#include <conncpp.hpp>
+
+namespace Luna::MDBSQL
+{
+    StatementCache::StatementCache(nstd::observer_ptr<sql::Connection> connection, std::size_t capacity)
+        : m_connection(connection),
+          m_capacity(capacity)
+    {
+        m_lookup.reserve(capacity);
+    }
+
+    StatementCache::~StatementCache() = default;
+
+    std::unique_ptr<sql::PreparedStatement> StatementCache::acquire(std::string_view sql)
+    {
+        {
+            std::lock_guard lock(m_mutex);
+
+            if (auto it = m_lookup.find(sql); it != m_lookup.end())
+            {
+                std::unique_ptr<sql::PreparedStatement> statement = std::move(it->second->statement);
+
+                m_entries.erase(it->second);
+                m_lookup.erase(it);
+                m_hits++;
+
+                return statement;
+            }
+
+            m_misses++;
+        }
+
+        // Prepare outside of the lock, it is a round trip to the server
+        return prepare(sql);
+    }
+
+    std::unique_ptr<sql::PreparedStatement> StatementCache::prepare(std::string_view sql)
+    {
+        return std::unique_ptr<sql::PreparedStatement>(m_connection->prepareStatement(sql.data()));
+    }
+
+    void StatementCache::release(std::string &&sql, std::unique_ptr<sql::PreparedStatement> &&statement)
+    {
+        if (!m_capacity || !statement)
+        {
+            return;
+        }
+
+        try
+        {
+            if (statement->isClosed())
+            {
+                return;
+            }
+
+            statement->clearParameters();
+            statement->clearBatch();
+        }
+        catch (const std::exception &e [[maybe_unused]])
+        {
+            return;
+        }
+
+        std::lock_guard lock(m_mutex);
+
+        // Another copy of the same statement was handed back first, keep that one
+        if (m_lookup.find(sql) != m_lookup.end())
+        {
+            return;
+        }
+
+        m_entries.push_front({std::move(sql), std::move(statement)});
+        m_lookup.emplace(m_entries.front().sql, m_entries.begin());
+
+        if (m_entries.size() > m_capacity)
+        {
+            m_lookup.erase(m_entries.back().sql);
+            m_entries.pop_back();
+            m_evictions++;
+        }
+    }
+
+    StatementCacheStats StatementCache::getStats() const
+    {
+        std::lock_guard lock(m_mutex);
+
+        return {m_entries.size(), m_capacity, m_hits, m_misses, m_evictions};
+    }
+}
\ No newline at end of file
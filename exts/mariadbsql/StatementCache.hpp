@@ -0,0 +1,76 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <IConnection.hpp>
+
+#include <anubis/observer_ptr.hpp>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace sql
+{
+    class Connection;
+    class PreparedStatement;
+}
+
+namespace Luna::MDBSQL
+{
+    /**
+     * @brief LRU cache of prepared statements keyed by their SQL text.
+     *
+     * Statements are checked out while in use and handed back when their owner
+     * is destroyed, so one statement is never shared by two callers.
+     */
+    class StatementCache
+    {
+    public:
+        StatementCache(nstd::observer_ptr<sql::Connection> connection, std::size_t capacity);
+        StatementCache(const StatementCache &) = delete;
+        StatementCache &operator=(const StatementCache &) = delete;
+        ~StatementCache();
+
+        std::unique_ptr<sql::PreparedStatement> acquire(std::string_view sql);
+        // Prepares a one-off statement which is never kept in the cache
+        std::unique_ptr<sql::PreparedStatement> prepare(std::string_view sql);
+        void release(std::string &&sql, std::unique_ptr<sql::PreparedStatement> &&statement);
+        StatementCacheStats getStats() const;
+
+    private:
+        struct Entry
+        {
+            std::string sql;
+            std::unique_ptr<sql::PreparedStatement> statement;
+        };
+
+    private:
+        nstd::observer_ptr<sql::Connection> m_connection;
+        std::size_t m_capacity;
+        // Most recently used statement is at the front
+        std::list<Entry> m_entries;
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> m_lookup;
+        std::uint64_t m_hits{};
+        std::uint64_t m_misses{};
+        std::uint64_t m_evictions{};
+        mutable std::mutex m_mutex;
+    };
+}
\ No newline at end of file
@@ -22,6 +22,25 @@
 #include "ExtSystem.hpp"
 #include "TimerSystem.hpp"
 #include "ConfigSystem.hpp"
+#include "SnapshotSystem.hpp"
+#include "SpatialIndex.hpp"
+#include "EntityIndex.hpp"
+#include "StringCache.hpp"
+#include "ClassHandler.hpp"
+#include "TracePool.hpp"
+#include "VisibilityCache.hpp"
+#include "WatchSystem.hpp"
+#include "EntityPool.hpp"
+#include "TweenSystem.hpp"
+#include "EntVars.hpp"
+#include "sql/AsyncDispatcher.hpp"
+#include "sql/WriteBehind.hpp"
+#include "sql/Handles.hpp"
+#include "sql/Natives.hpp"
+
+#include <engine/IEdict.hpp>
+#include <engine/IHooks.hpp>
+#include <game/IBaseEntity.hpp>
 
 nstd::observer_ptr<Anubis::IAnubis> gAnubisApi;
 nstd::observer_ptr<Anubis::Game::ILibrary> gGame;
@@ -53,6 +72,16 @@ namespace
     {
         hook->callNext();
 
+        gPlayerSnapshot->capture();
+        gSpatialIndex->update();
+        gEntityIndex->update();
+        gVisibilityCache->reset();
+        gPropertyWatcher->update();
+        gTweenSystem->update();
+        gSQLWriteBehind->update();
+        gSQLDispatcher->dispatch();
+        flushSQLGroupCommits();
+
         for (auto it = gTimers.begin(); it != gTimers.end(); it++)
         {
             auto &timer = *it;
@@ -66,6 +95,99 @@ namespace
             }
         }
     }
+
+    void SetOrigin(const std::unique_ptr<Anubis::Engine::ISetOriginHook> &hook,
+                   nstd::observer_ptr<Anubis::Engine::IEdict> edict,
+                   std::array<float, 3> origin)
+    {
+        hook->callNext(edict, origin);
+
+        gSpatialIndex->markDirty(edict->getIndex());
+    }
+
+    void RemoveEntity(const std::unique_ptr<Anubis::Engine::IRemoveEntityHook> &hook,
+                      nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        Luna::forgetEntity(edict->getIndex());
+
+        hook->callNext(edict);
+    }
+
+    nstd::observer_ptr<Anubis::Engine::IEdict> CreateEntity(
+        const std::unique_ptr<Anubis::Engine::ICreateEntityHook> &hook)
+    {
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict = hook->callNext();
+
+        if (edict)
+        {
+            gEntityIndex->markDirty(edict->getIndex());
+        }
+
+        return edict;
+    }
+
+    nstd::observer_ptr<Anubis::Engine::IEdict> CreateNamedEntity(
+        const std::unique_ptr<Anubis::Engine::ICreateNamedEntityHook> &hook,
+        Anubis::Engine::StringOffset className)
+    {
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict = hook->callNext(className);
+
+        if (edict)
+        {
+            gEntityIndex->markDirty(edict->getIndex());
+        }
+
+        return edict;
+    }
+
+    std::unique_ptr<Anubis::Game::IBaseEntity> AllocEntPrivData(
+        const std::unique_ptr<Anubis::Engine::IAllocEntPrivateDataHook> &hook,
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict,
+        std::int32_t size)
+    {
+        gEntityIndex->markDirty(edict->getIndex());
+
+        return hook->callNext(edict, size);
+    }
+
+    void ServerActivate(const std::unique_ptr<Anubis::Game::IServerActivateHook> &hook,
+                        std::uint32_t edictCount,
+                        std::uint32_t clientMax)
+    {
+        hook->callNext(edictCount, clientMax);
+
+        gSpatialIndex->rebuild(edictCount);
+        gEntityIndex->rebuild();
+    }
+
+    void ClientPutinServer(const std::unique_ptr<Anubis::Game::IClientPutinServerHook> &hook,
+                           nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        hook->callNext(edict);
+
+        gClassHandler.create<Anubis::Game::IBasePlayer>(gGame->getBasePlayer(edict));
+    }
+
+    void ClientDisconnect(const std::unique_ptr<Anubis::Game::IClientDisconnectHook> &hook,
+                          nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        hook->callNext(edict);
+
+        gClassHandler.invalidate(edict->getIndex());
+    }
+
+    void ServerDeactivate(const std::unique_ptr<Anubis::Game::IServerDeactivateHook> &hook)
+    {
+        gSpatialIndex->clear();
+        gEntityIndex->clear();
+        gStringCache->clear();
+        gClassHandler.clear();
+        gEntityPool->clear();
+        gEntVarsView->clear();
+        gSQLWriteBehind->flushAll();
+
+        hook->callNext();
+    }
 }
 
 namespace Anubis
@@ -94,9 +216,35 @@ namespace Anubis
 
         gLogger->setLogLevel(static_cast<Anubis::LogLevel>(gConfig->getLogLevel()));
 
+        gPlayerSnapshot = std::make_unique<Luna::PlayerSnapshot>(gConfig->getSnapshotProperties());
+        gSpatialIndex = std::make_unique<Luna::SpatialIndex>();
+        gEntityIndex = std::make_unique<Luna::EntityIndex>();
+        gStringCache = std::make_unique<Luna::StringCache>();
+        gTracePool = std::make_unique<Luna::TracePool>();
+        gVisibilityCache = std::make_unique<Luna::VisibilityCache>();
+        gPropertyWatcher = std::make_unique<Luna::PropertyWatcher>();
+        gEntityPool = std::make_unique<Luna::EntityPool>(gConfig->getEntityPoolSize());
+        gTweenSystem = std::make_unique<Luna::TweenSystem>();
+        gEntVarsView = std::make_unique<Luna::EntVarsView>(gConfig->isEntVarsDirectAccess());
+        gSQLDispatcher = std::make_unique<Luna::SQLDispatcher>(gConfig->getSQLAsyncWorkers(),
+                                                               gConfig->getSQLMaxCompletionsPerFrame());
+        gSQLWriteBehind = std::make_unique<Luna::SQLWriteBehind>(gConfig->getSQLWriteBehindInterval(),
+                                                                 gConfig->getSQLWriteBehindMaxPending());
+        gSQLHandles = std::make_unique<Luna::SQLHandles>();
+
         loadExts();
+        initSQLDriver();
         gPluginSystem = std::make_unique<Luna::PluginSystem>(gConfig->getPluginsDirName());
         gGame->getHooks()->startFrame()->registerHook(ServerFrame, Anubis::HookPriority::Default);
+        gGame->getHooks()->serverActivate()->registerHook(ServerActivate, Anubis::HookPriority::Default);
+        gGame->getHooks()->serverDeactivate()->registerHook(ServerDeactivate, Anubis::HookPriority::Default);
+        gGame->getHooks()->clientPutinServer()->registerHook(ClientPutinServer, Anubis::HookPriority::Default);
+        gGame->getHooks()->clientDisconnect()->registerHook(ClientDisconnect, Anubis::HookPriority::Default);
+        gEngine->getHooks()->setOrigin()->registerHook(SetOrigin, Anubis::HookPriority::Default);
+        gEngine->getHooks()->removeEntity()->registerHook(RemoveEntity, Anubis::HookPriority::Default);
+        gEngine->getHooks()->createEntity()->registerHook(CreateEntity, Anubis::HookPriority::Default);
+        gEngine->getHooks()->createNamedEntity()->registerHook(CreateNamedEntity, Anubis::HookPriority::Default);
+        gEngine->getHooks()->allocEntPrivData()->registerHook(AllocEntPrivData, Anubis::HookPriority::Default);
 
         return true;
     }
@@ -104,6 +252,8 @@ namespace Anubis
     void Shutdown()
     {
         gPluginSystem->unloadPlugins();
+        gSQLDispatcher->shutdown();
+        gTracePool.reset();
         gLogger.reset();
     }
 }
\ No newline at end of file
@@ -19,6 +19,7 @@
 
 #include "BasicNatives.hpp"
 #include "AnubisExports.hpp"
+#include "EntityHandle.hpp"
 #include <game/IHooks.hpp>
 #include <engine/IEdict.hpp>
 #include <fmt/format.h>
@@ -51,7 +52,7 @@ static int callNext(lua_State *L)
         case GameHooks::ClientConnect:
         {
             auto hook = reinterpret_cast<Anubis::Game::IClientConnectHook *>(lua_touserdata(L, 2));
-            auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 3));
+            auto edict = Luna::checkEdict(L, 3);
             std::string_view name = luaL_checklstring(L, 4, &length);
             std::string_view ip = luaL_checklstring(L, 5, &length);
             std::string_view reason = luaL_checklstring(L, 6, &length);
@@ -66,14 +67,14 @@ static int callNext(lua_State *L)
         case GameHooks::ClientCmd:
         {
             auto hook = reinterpret_cast<Anubis::Game::IClientCmdHook *>(lua_touserdata(L, 2));
-            auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 3));
+            auto edict = Luna::checkEdict(L, 3);
             hook->callNext(edict);
             break;
         }
         case GameHooks::ClientInfoChanged:
         {
             auto hook = reinterpret_cast<Anubis::Game::IClientInfoChangedHook *>(lua_touserdata(L, 2));
-            auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 3));
+            auto edict = Luna::checkEdict(L, 3);
             auto infoBuffer = reinterpret_cast<Anubis::Engine::InfoBuffer *>(lua_touserdata(L, 4));
             hook->callNext(edict, *infoBuffer);
             break;
@@ -121,7 +122,7 @@ static int callOriginal(lua_State *L)
         case GameHooks::ClientConnect:
         {
             auto hook = reinterpret_cast<Anubis::Game::IClientConnectHook *>(lua_touserdata(L, 2));
-            auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 3));
+            auto edict = Luna::checkEdict(L, 3);
             std::string_view name = luaL_checklstring(L, 4, &length);
             std::string_view ip = luaL_checklstring(L, 5, &length);
             bool result = hook->callOriginal(edict, name, ip, gConnectReason);
@@ -132,14 +133,14 @@ static int callOriginal(lua_State *L)
         case GameHooks::ClientCmd:
         {
             auto hook = reinterpret_cast<Anubis::Game::IClientCmdHook *>(lua_touserdata(L, 2));
-            auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 3));
+            auto edict = Luna::checkEdict(L, 3);
             hook->callOriginal(edict);
             break;
         }
         case GameHooks::ClientInfoChanged:
         {
             auto hook = reinterpret_cast<Anubis::Game::IClientInfoChangedHook *>(lua_touserdata(L, 2));
-            auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 3));
+            auto edict = Luna::checkEdict(L, 3);
             auto infoBuffer = reinterpret_cast<Anubis::Engine::InfoBuffer *>(lua_touserdata(L, 4));
             hook->callOriginal(edict, *infoBuffer);
             break;
@@ -201,7 +202,7 @@ static int gameFnHook(lua_State *L)
                     }
 
                     lua_pushlightuserdata(L, hook.get());
-                    lua_pushlightuserdata(L, pEdict.get());
+                    Luna::pushEdict(L, pEdict);
                     lua_pushstring(L, name.data());
                     lua_pushstring(L, ip.data());
                     lua_pushstring(L, reason->c_str());
@@ -237,7 +238,7 @@ static int gameFnHook(lua_State *L)
                     }
 
                     lua_pushlightuserdata(L, hook.get());
-                    lua_pushlightuserdata(L, pEdict.get());
+                    Luna::pushEdict(L, pEdict);
 
                     if (lua_pcall(L, 2, 0, 0) != LUA_OK)
                     {
@@ -260,7 +261,7 @@ static int gameFnHook(lua_State *L)
                     }
 
                     lua_pushlightuserdata(L, hook.get());
-                    lua_pushlightuserdata(L, pEdict.get());
+                    Luna::pushEdict(L, pEdict);
                     lua_pushlightuserdata(L, &infoBuffer);
 
                     if (lua_pcall(L, 3, 0, 0) != LUA_OK)
@@ -487,7 +488,7 @@ static int infoKeyValue(lua_State *L)
 
 static int clientPrint(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::toEdict(L, 1);
     auto printType = static_cast<Anubis::Engine::PrintType>(luaL_checkinteger(L, 2));
     std::size_t length;
     const char *msg = luaL_checklstring(L, 3, &length);
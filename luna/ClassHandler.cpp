@@ -19,4 +19,31 @@
 
 #include "ClassHandler.hpp"
 
-ClassHandler gClassHandler;
\ No newline at end of file
+void ClassHandler::invalidate(std::uint32_t index)
+{
+    if (index >= MAX_EDICTS)
+    {
+        return;
+    }
+
+    Slot &slot = m_slots[index];
+
+    for (std::size_t i = 0; i < TYPES; i++)
+    {
+        slot.typed[i] = nullptr;
+        slot.entities[i].reset();
+    }
+
+    slot.edict = nullptr;
+    slot.serialNumber = 0;
+}
+
+void ClassHandler::clear()
+{
+    for (auto &slot : m_slots)
+    {
+        slot = {};
+    }
+}
+
+ClassHandler gClassHandler;
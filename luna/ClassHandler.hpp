@@ -22,35 +22,51 @@
 #include <game/IBaseEntity.hpp>
 #include <game/IBasePlayer.hpp>
 #include <engine/IEdict.hpp>
+#include <array>
 #include <memory>
-#include <vector>
 #include <type_traits>
 
-class ClassHandler
+enum class EntityType : std::uint8_t
 {
-    private:
-        class EntityHandle
-        {
-        public:
-            explicit EntityHandle() = default;
+    BaseEntity = 0,
+    BasePlayer
+};
 
-            explicit EntityHandle(std::unique_ptr<Anubis::Game::IBaseEntity> &&pEntity)
-                : m_pEntity(std::move(pEntity)), m_edict(m_pEntity->edict()), m_serialNumber(m_edict->getSerialNumber()) {}
+template<typename T>
+struct EntityTypeTag;
 
-            [[nodiscard]] const std::unique_ptr<Anubis::Game::IBaseEntity> &get() const
-            {
-                return m_pEntity;
-            }
+template<>
+struct EntityTypeTag<Anubis::Game::IBaseEntity>
+{
+    static constexpr EntityType value = EntityType::BaseEntity;
+};
 
-            [[nodiscard]] bool isValid() const
-            {
-                return m_pEntity->isValid() && m_serialNumber == m_edict->getSerialNumber();
-            }
+template<>
+struct EntityTypeTag<Anubis::Game::IBasePlayer>
+{
+    static constexpr EntityType value = EntityType::BasePlayer;
+};
 
-        private:
-            std::unique_ptr<Anubis::Game::IBaseEntity> m_pEntity{};
-            nstd::observer_ptr<Anubis::Engine::IEdict> m_edict{};
-            std::uint32_t m_serialNumber{};
+/**
+ * @brief Owns the entity wrappers handed out to plugins.
+ *
+ * Wrappers are stored per edict index, one per type tag, and validated
+ * against the edict serial number. Lua refers to them by edict index, so a
+ * lookup is a single array access.
+ */
+class ClassHandler
+{
+    public:
+        static constexpr std::uint32_t MAX_EDICTS = 2048;
+        static constexpr std::size_t TYPES = static_cast<std::size_t>(EntityType::BasePlayer) + 1;
+
+    private:
+        struct Slot
+        {
+            nstd::observer_ptr<Anubis::Engine::IEdict> edict{};
+            std::uint32_t serialNumber{};
+            std::array<std::unique_ptr<Anubis::Game::IBaseEntity>, TYPES> entities{};
+            std::array<void *, TYPES> typed{};
         };
 
     public:
@@ -60,41 +76,75 @@ class ClassHandler
         template<typename T = Anubis::Game::IBaseEntity, typename = std::enable_if_t<std::is_base_of_v<Anubis::Game::IBaseEntity, T>>>
         std::add_pointer_t<T> create(std::add_rvalue_reference_t<std::unique_ptr<T>> pEntity)
         {
-            const auto &[iter, inserted] = m_entHandles.try_emplace(pEntity.get(), std::move(pEntity));
+            constexpr auto type = static_cast<std::size_t>(EntityTypeTag<T>::value);
+
+            if (!pEntity)
+            {
+                return {};
+            }
+
+            nstd::observer_ptr<Anubis::Engine::IEdict> edict = pEntity->edict();
+            std::uint32_t index = edict->getIndex();
+
+            if (index >= MAX_EDICTS)
+            {
+                return {};
+            }
+
+            Slot &slot = m_slots[index];
+            if (slot.edict != edict || slot.serialNumber != edict->getSerialNumber())
+            {
+                invalidate(index);
+
+                slot.edict = edict;
+                slot.serialNumber = edict->getSerialNumber();
+            }
+
+            // Reuse the wrapper already handed out for this entity
+            if (slot.typed[type])
+            {
+                return static_cast<std::add_pointer_t<T>>(slot.typed[type]);
+            }
+
+            std::add_pointer_t<T> ptr = pEntity.get();
+
+            slot.typed[type] = ptr;
+            slot.entities[type] = std::move(pEntity);
 
-            return dynamic_cast<std::add_pointer_t<T>>(iter->first);
+            return ptr;
         }
 
         template<typename T = Anubis::Game::IBaseEntity, typename = std::enable_if_t<std::is_base_of_v<Anubis::Game::IBaseEntity, T>>>
-        std::add_pointer_t<T> get(std::add_pointer_t<T> pEntity)
+        std::add_pointer_t<T> getByIndex(std::uint32_t index)
         {
-            for (auto iter = m_entHandles.begin(); iter != m_entHandles.end(); iter++)
+            constexpr auto type = static_cast<std::size_t>(EntityTypeTag<T>::value);
+
+            if (index >= MAX_EDICTS)
             {
-                if (!(iter->second).isValid())
-                {
-                    if (iter = m_entHandles.erase(iter); iter == m_entHandles.end())
-                    {
-                        break;
-                    }
-                }
-                if ((iter->second).get().get() == pEntity)
-                {
-                    try
-                    {
-                        return dynamic_cast<std::add_pointer_t<T>>((iter->second).get().get());
-                    }
-                    catch (const std::bad_cast &)
-                    {
-                        return {};
-                    }
-                }
+                return {};
             }
 
-            return {};
+            const Slot &slot = m_slots[index];
+            if (!slot.typed[type])
+            {
+                return {};
+            }
+
+            if (slot.edict->isFree() || slot.serialNumber != slot.edict->getSerialNumber() ||
+                !slot.entities[type]->isValid())
+            {
+                invalidate(index);
+                return {};
+            }
+
+            return static_cast<std::add_pointer_t<T>>(slot.typed[type]);
         }
 
+        void invalidate(std::uint32_t index);
+        void clear();
+
     private:
-        std::unordered_map<Anubis::Game::IBaseEntity *, EntityHandle> m_entHandles;
+        std::array<Slot, MAX_EDICTS> m_slots{};
 };
 
-extern ClassHandler gClassHandler;
\ No newline at end of file
+extern ClassHandler gClassHandler;
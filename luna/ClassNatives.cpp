@@ -26,6 +26,7 @@
 #include <game/IBaseEntity.hpp>
 #include <game/IBasePlayer.hpp>
 #include "ClassHandler.hpp"
+#include "EntityHandle.hpp"
 
 static float *gFlTakeDamage;
 
@@ -293,13 +294,37 @@ static int playerClassFnUnhook(lua_State *L)
     return 0;
 }
 
-static int getEdictFromPlayerClass(lua_State *L)
+// Players are addressed by their edict handle, the wrapper lives in the per-index ClassHandler slot
+static Anubis::Game::IBasePlayer *toPlayer(lua_State *L, int arg)
 {
-    auto entity = reinterpret_cast<Anubis::Game::IBasePlayer *>(lua_touserdata(L, 1));
+    nstd::observer_ptr<Anubis::Engine::IEdict> edict = Luna::toEdict(L, arg);
+
+    if (!edict)
+    {
+        return nullptr;
+    }
+
+    auto flags = static_cast<std::uint32_t>(edict->getFlags());
+    if (!(flags & static_cast<std::uint32_t>(Anubis::Engine::IEdict::Flag::Client)))
+    {
+        return nullptr;
+    }
+
+    // Wrappers are created on clientPutinServer, only fall back to allocating one for players not seen there
+    auto player = gClassHandler.getByIndex<Anubis::Game::IBasePlayer>(edict->getIndex());
+    if (!player)
+    {
+        player = gClassHandler.create<Anubis::Game::IBasePlayer>(gGame->getBasePlayer(edict));
+    }
 
-    if (gClassHandler.get<Anubis::Game::IBasePlayer>(entity))
+    return player;
+}
+
+static int getEdictFromPlayerClass(lua_State *L)
+{
+    if (auto player = toPlayer(L, 1))
     {
-        lua_pushlightuserdata(L, entity->edict().get());
+        Luna::pushEdict(L, player->edict());
         return 1;
     }
 
@@ -308,11 +333,9 @@ static int getEdictFromPlayerClass(lua_State *L)
 
 static int getEdictFromBaseClass(lua_State *L)
 {
-    auto entity = reinterpret_cast<Anubis::Game::IBaseEntity *>(lua_touserdata(L, 1));
-
-    if (gClassHandler.get<Anubis::Game::IBaseEntity>(entity))
+    if (auto edict = Luna::toEdict(L, 1))
     {
-        lua_pushlightuserdata(L, entity->edict().get());
+        Luna::pushEdict(L, edict);
         return 1;
     }
 
@@ -323,7 +346,7 @@ static int getEdictFromPlayerClassInHook(lua_State *L)
 {
     auto entity = reinterpret_cast<Anubis::Game::IBasePlayer *>(lua_touserdata(L, 1));
 
-    lua_pushlightuserdata(L, entity->edict().get());
+    Luna::pushEdict(L, entity->edict());
     return 1;
 }
 
@@ -331,27 +354,29 @@ static int getEdictFromBaseClassInHook(lua_State *L)
 {
     auto entity = reinterpret_cast<Anubis::Game::IBaseEntity *>(lua_touserdata(L, 1));
 
-    lua_pushlightuserdata(L, entity->edict().get());
+    Luna::pushEdict(L, entity->edict());
     return 1;
 }
 
 static int getPlayerFromEdict(lua_State *L)
 {
-    auto entity = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto player = toPlayer(L, 1);
 
-    auto player = gClassHandler.create<Anubis::Game::IBasePlayer>(gGame->getBasePlayer(entity));
+    if (!player)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
 
-    lua_pushlightuserdata(L, player);
+    Luna::pushEdict(L, player->edict());
     return 1;
 }
 
 static int spawnPlayerClass(lua_State *L)
 {
-    auto entity = reinterpret_cast<Anubis::Game::IBasePlayer *>(lua_touserdata(L, 1));
-
-    if (gClassHandler.get<Anubis::Game::IBasePlayer>(entity))
+    if (auto player = toPlayer(L, 1))
     {
-        entity->spawn();
+        player->spawn();
     }
 
     return 0;
@@ -359,9 +384,9 @@ static int spawnPlayerClass(lua_State *L)
 
 static int giveNamedItemToPlayer(lua_State *L)
 {
-    auto player = reinterpret_cast<Anubis::Game::IBasePlayer *>(lua_touserdata(L, 1));
+    auto player = toPlayer(L, 1);
 
-    if (!gClassHandler.get<Anubis::Game::IBasePlayer>(player))
+    if (!player)
     {
         return 0;
     }
@@ -371,12 +396,12 @@ static int giveNamedItemToPlayer(lua_State *L)
 
     std::optional<std::unique_ptr<Anubis::Game::IBaseEntity>> entity = player->giveNamedItem(item);
 
-    if (!entity)
+    if (!entity || !*entity)
     {
         return 0;
     }
 
-    lua_pushlightuserdata(L, gClassHandler.create<Anubis::Game::IBaseEntity>(std::move(*entity)));
+    Luna::pushEdict(L, (*entity)->edict());
     return 1;
 }
 
@@ -27,4 +27,17 @@ struct LuaAdapterCFunction
 {
     const char *name;
     lua_CFunction func;
-};
\ No newline at end of file
+};
+
+namespace Luna
+{
+    // Natives may run in a coroutine, state kept past the call belongs to the plugin's main thread
+    inline lua_State *getMainThread(lua_State *L)
+    {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, LUA_RIDX_MAINTHREAD);
+        lua_State *mainThread = lua_tothread(L, -1);
+        lua_pop(L, 1);
+
+        return mainThread;
+    }
+}
\ No newline at end of file
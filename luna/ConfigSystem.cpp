@@ -21,6 +21,9 @@
 
 #include <yaml-cpp/yaml.h>
 
+#include <algorithm>
+#include <cctype>
+
 namespace Luna
 {
     Config::Config(std::filesystem::path &&cfgFile)
@@ -63,6 +66,59 @@ namespace Luna
             {
                 m_pluginsDirName = it->second["plugins"].as<std::string>();
             }
+            else if (nodeName == "snapshot")
+            {
+                m_snapshotProperties = it->second["properties"].as<std::vector<std::string>>();
+            }
+            else if (nodeName == "entity_pool")
+            {
+                m_entityPoolSize = it->second["max_per_plugin"].as<std::size_t>();
+            }
+            else if (nodeName == "entvars")
+            {
+                m_entVarsDirectAccess = it->second["direct_access"].as<bool>();
+            }
+            else if (nodeName == "sql")
+            {
+                if (auto async = it->second["async"]; async)
+                {
+                    m_sqlAsyncWorkers = async["workers"].as<std::size_t>();
+                    m_sqlMaxCompletionsPerFrame = async["max_completions_per_frame"].as<std::size_t>();
+                }
+
+                if (auto cacheSize = it->second["statement_cache_size"]; cacheSize)
+                {
+                    m_sqlStatementCacheSize = cacheSize.as<std::size_t>();
+                }
+
+                if (auto groupCommitWindow = it->second["group_commit_window"]; groupCommitWindow)
+                {
+                    m_sqlGroupCommitWindow = groupCommitWindow.as<std::uint32_t>();
+                }
+
+                if (auto writeBehind = it->second["write_behind"]; writeBehind)
+                {
+                    m_sqlWriteBehindInterval = writeBehind["flush_interval"].as<float>();
+                    m_sqlWriteBehindMaxPending = writeBehind["max_pending"].as<std::size_t>();
+                }
+
+                if (auto cursor = it->second["cursor"]; cursor)
+                {
+                    m_sqlCursorFetchSize = cursor["fetch_size"].as<std::size_t>();
+                    m_sqlCursorMaxBuffered = cursor["max_buffered"].as<std::size_t>();
+                }
+
+                for (const auto &pool : it->second["pools"])
+                {
+                    m_sqlPools.push_back({pool["name"].as<std::string>(),
+                                          pool["url"].as<std::string>(),
+                                          pool["user"].as<std::string>(),
+                                          pool["password"].as<std::string>(),
+                                          pool["min"].as<std::size_t>(),
+                                          pool["max"].as<std::size_t>(),
+                                          pool["idle_timeout"].as<std::uint32_t>()});
+                }
+            }
         }
     }
 
@@ -75,6 +131,66 @@ namespace Luna
     {
         return m_logLevel;
     }
+
+    const std::vector<std::string> &Config::getSnapshotProperties() const
+    {
+        return m_snapshotProperties;
+    }
+
+    std::size_t Config::getEntityPoolSize() const
+    {
+        return m_entityPoolSize;
+    }
+
+    bool Config::isEntVarsDirectAccess() const
+    {
+        return m_entVarsDirectAccess;
+    }
+
+    std::size_t Config::getSQLAsyncWorkers() const
+    {
+        return m_sqlAsyncWorkers;
+    }
+
+    std::size_t Config::getSQLMaxCompletionsPerFrame() const
+    {
+        return m_sqlMaxCompletionsPerFrame;
+    }
+
+    const std::vector<Config::SQLPool> &Config::getSQLPools() const
+    {
+        return m_sqlPools;
+    }
+
+    std::size_t Config::getSQLStatementCacheSize() const
+    {
+        return m_sqlStatementCacheSize;
+    }
+
+    float Config::getSQLWriteBehindInterval() const
+    {
+        return m_sqlWriteBehindInterval;
+    }
+
+    std::size_t Config::getSQLWriteBehindMaxPending() const
+    {
+        return m_sqlWriteBehindMaxPending;
+    }
+
+    std::uint32_t Config::getSQLGroupCommitWindow() const
+    {
+        return m_sqlGroupCommitWindow;
+    }
+
+    std::size_t Config::getSQLCursorFetchSize() const
+    {
+        return m_sqlCursorFetchSize;
+    }
+
+    std::size_t Config::getSQLCursorMaxBuffered() const
+    {
+        return m_sqlCursorMaxBuffered;
+    }
 }
 
 std::unique_ptr<Luna::Config> gConfig;
@@ -19,7 +19,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <vector>
 #include <filesystem>
 
 namespace Luna
@@ -33,15 +35,50 @@ namespace Luna
             Info,
         };
 
+        struct SQLPool
+        {
+            std::string name;
+            std::string url;
+            std::string user;
+            std::string password;
+            std::size_t minSize;
+            std::size_t maxSize;
+            std::uint32_t idleTimeout;
+        };
+
     public:
         explicit Config(std::filesystem::path &&cfgFile);
 
         std::string_view getPluginsDirName() const;
         LogLevel getLogLevel() const;
+        const std::vector<std::string> &getSnapshotProperties() const;
+        std::size_t getEntityPoolSize() const;
+        bool isEntVarsDirectAccess() const;
+        std::size_t getSQLAsyncWorkers() const;
+        std::size_t getSQLMaxCompletionsPerFrame() const;
+        const std::vector<SQLPool> &getSQLPools() const;
+        std::size_t getSQLStatementCacheSize() const;
+        float getSQLWriteBehindInterval() const;
+        std::size_t getSQLWriteBehindMaxPending() const;
+        std::uint32_t getSQLGroupCommitWindow() const;
+        std::size_t getSQLCursorFetchSize() const;
+        std::size_t getSQLCursorMaxBuffered() const;
 
     private:
         LogLevel m_logLevel;
         std::string m_pluginsDirName;
+        std::vector<std::string> m_snapshotProperties;
+        std::size_t m_entityPoolSize = 64;
+        bool m_entVarsDirectAccess = false;
+        std::size_t m_sqlAsyncWorkers = 2;
+        std::size_t m_sqlMaxCompletionsPerFrame = 16;
+        std::vector<SQLPool> m_sqlPools;
+        std::size_t m_sqlStatementCacheSize = 32;
+        float m_sqlWriteBehindInterval = 5.0f;
+        std::size_t m_sqlWriteBehindMaxPending = 256;
+        std::uint32_t m_sqlGroupCommitWindow = 50;
+        std::size_t m_sqlCursorFetchSize = 500;
+        std::size_t m_sqlCursorMaxBuffered = 5000;
     };
 }
 
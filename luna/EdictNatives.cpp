@@ -21,19 +21,24 @@
 #include <observer_ptr.hpp>
 #include <engine/IEdict.hpp>
 #include "AnubisExports.hpp"
+#include "EntityHandle.hpp"
+#include "Vec3Natives.hpp"
+#include "SpatialIndex.hpp"
+#include "EntityIndex.hpp"
+#include "StringCache.hpp"
 
 #include <array>
 #include <cstddef>
 
 static int setModel(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     size_t length;
     const char *model = luaL_checklstring(L, 2, &length);
 
     std::string_view staticModel = gEngine->getString(
-        gEngine->allocString(model, Anubis::FuncCallType::Direct),
+        gStringCache->alloc({model, length}),
         Anubis::FuncCallType::Direct
     );
 
@@ -44,30 +49,26 @@ static int setModel(lua_State *L)
 
 static int setOrigin(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
-    auto x = static_cast<float>(lua_tonumber(L, 2));
-    auto y = static_cast<float>(lua_tonumber(L, 3));
-    auto z = static_cast<float>(lua_tonumber(L, 4));
+    std::array<float, 3> origin {};
+    Luna::getVec3Args(L, 2, origin);
 
-    gEngine->setOrigin(edict, { x, y, z }, Anubis::FuncCallType::Direct);
+    gEngine->setOrigin(edict, origin, Anubis::FuncCallType::Direct);
+    gSpatialIndex->markDirty(edict->getIndex());
 
     return 0;
 }
 
 static int setSize(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
-    auto minX = static_cast<float>(lua_tonumber(L, 2));
-    auto minY = static_cast<float>(lua_tonumber(L, 3));
-    auto minZ = static_cast<float>(lua_tonumber(L, 4));
+    std::array<float, 3> mins {};
+    std::array<float, 3> maxs {};
+    Luna::getVec3Args(L, Luna::getVec3Args(L, 2, mins), maxs);
 
-    auto maxX = static_cast<float>(lua_tonumber(L, 5));
-    auto maxY = static_cast<float>(lua_tonumber(L, 6));
-    auto maxZ = static_cast<float>(lua_tonumber(L, 7));
-
-    gEngine->setSize(edict, { minX, minY, minZ }, { maxX, maxY, maxZ }, Anubis::FuncCallType::Direct);
+    gEngine->setSize(edict, mins, maxs, Anubis::FuncCallType::Direct);
 
     return 0;
 }
@@ -76,24 +77,22 @@ static int createEntity(lua_State *L)
 {
     auto edict = gEngine->createEntity(Anubis::FuncCallType::Direct);
 
-    if (!edict)
-    {
-        lua_pushnil(L);
-    }
-    else
+    if (edict)
     {
-        lua_pushlightuserdata(L, edict.get());
+        gEntityIndex->markDirty(edict->getIndex());
     }
 
+    Luna::pushEdict(L, edict);
+
     return 1;
 }
 
 static int removeEntity(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::toEdict(L, 1);
     if (edict)
     {
-        gEngine->removeEntity(edict, Anubis::FuncCallType::Direct);
+        Luna::removeEntity(edict);
     }
 
     return 0;
@@ -104,25 +103,23 @@ static int createNamedEntity(lua_State *L)
     size_t length;
     const char *name = luaL_checklstring(L, 1, &length);
 
-    Anubis::Engine::StringOffset className = gEngine->allocString(name, Anubis::FuncCallType::Direct);
+    Anubis::Engine::StringOffset className = gStringCache->alloc({name, length});
 
     auto edict = gEngine->createNamedEntity(className, Anubis::FuncCallType::Direct);
 
-    if (!edict)
-    {
-        lua_pushnil(L);
-    }
-    else
+    if (edict)
     {
-        lua_pushlightuserdata(L, edict.get());
+        gEntityIndex->markDirty(edict->getIndex());
     }
 
+    Luna::pushEdict(L, edict);
+
     return 1;
 }
 
 static int setFloatProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::FlProperty>(luaL_checkinteger(L, 2));
     auto value = static_cast<float>(luaL_checknumber(L, 3));
 
@@ -132,7 +129,7 @@ static int setFloatProperty(lua_State *L)
 
 static int setIntProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::IntProperty>(luaL_checkinteger(L, 2));
     auto value = static_cast<std::int32_t>(luaL_checkinteger(L, 3));
 
@@ -142,13 +139,10 @@ static int setIntProperty(lua_State *L)
 
 static int setVecProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::VecProperty>(luaL_checkinteger(L, 2));
-    auto value1 = static_cast<float>(luaL_checknumber(L, 3));
-    auto value2 = static_cast<float>(luaL_checknumber(L, 4));
-    auto value3 = static_cast<float>(luaL_checknumber(L, 5));
-
-    std::array<float, 3> vector = {value1, value2, value3};
+    std::array<float, 3> vector {};
+    Luna::getVec3Args(L, 3, vector);
 
     edict->setVecProperty(property, vector);
     return 0;
@@ -156,19 +150,26 @@ static int setVecProperty(lua_State *L)
 
 static int setStrProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::StrProperty>(luaL_checkinteger(L, 2));
     std::size_t length;
     const char *value = luaL_checklstring(L, 3, &length);
-    Anubis::Engine::StringOffset strOffset = gEngine->allocString(value, Anubis::FuncCallType::Direct);
+    Anubis::Engine::StringOffset strOffset = gStringCache->alloc({value, length});
 
     edict->setStrProperty(property, strOffset);
+
+    if (property == Anubis::Engine::IEdict::StrProperty::ClassName ||
+        property == Anubis::Engine::IEdict::StrProperty::TargetName)
+    {
+        gEntityIndex->sync(edict->getIndex());
+    }
+
     return 0;
 }
 
 static int setShortProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::ShortProperty>(luaL_checkinteger(L, 2));
     auto value = static_cast<std::int16_t>(luaL_checkinteger(L, 3));
 
@@ -178,7 +179,7 @@ static int setShortProperty(lua_State *L)
 
 static int setUShortProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::UShortProperty>(luaL_checkinteger(L, 2));
     auto value = static_cast<std::uint16_t>(luaL_checkinteger(L, 3));
 
@@ -188,7 +189,7 @@ static int setUShortProperty(lua_State *L)
 
 static int setByteProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::ByteProperty>(luaL_checkinteger(L, 2));
     auto value = static_cast<std::uint8_t>(luaL_checknumber(L, 3));
 
@@ -198,9 +199,9 @@ static int setByteProperty(lua_State *L)
 
 static int setEdictProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::EdictProperty>(luaL_checkinteger(L, 2));
-    auto value = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 3));
+    auto value = Luna::toEdict(L, 3);
 
     edict->setEdictProperty(property, value);
     return 0;
@@ -208,7 +209,7 @@ static int setEdictProperty(lua_State *L)
 
 static int getFloatProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::FlProperty>(luaL_checkinteger(L, 2));
 
     lua_pushnumber(L, edict->getFlProperty(property));
@@ -217,7 +218,7 @@ static int getFloatProperty(lua_State *L)
 
 static int getIntProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::IntProperty>(luaL_checkinteger(L, 2));
 
     lua_pushinteger(L, edict->getIntProperty(property));
@@ -226,7 +227,7 @@ static int getIntProperty(lua_State *L)
 
 static int getVecProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::VecProperty>(luaL_checkinteger(L, 2));
 
     std::array<float, 3> result = edict->getVecProperty(property);
@@ -237,9 +238,31 @@ static int getVecProperty(lua_State *L)
     return 3;
 }
 
+static int getVec3Property(lua_State *L)
+{
+    auto edict = Luna::checkEdict(L, 1);
+    auto property = static_cast<Anubis::Engine::IEdict::VecProperty>(luaL_checkinteger(L, 2));
+
+    std::array<float, 3> result = edict->getVecProperty(property);
+
+    // Fill the Vec3 passed as the third argument instead of allocating a new one
+    if (Luna::Vec3 *out = Luna::toVec3(L, 3))
+    {
+        out->x = result[0];
+        out->y = result[1];
+        out->z = result[2];
+
+        lua_settop(L, 3);
+        return 1;
+    }
+
+    Luna::pushVec3(L, result);
+    return 1;
+}
+
 static int getStrProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::StrProperty>(luaL_checkinteger(L, 2));
 
     Anubis::Engine::StringOffset strOffset = edict->getStrProperty(property);
@@ -252,7 +275,7 @@ static int getStrProperty(lua_State *L)
 
 static int getShortProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::ShortProperty>(luaL_checkinteger(L, 2));
 
     lua_pushinteger(L, edict->getShortProperty(property));
@@ -261,7 +284,7 @@ static int getShortProperty(lua_State *L)
 
 static int getUShortProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::UShortProperty>(luaL_checkinteger(L, 2));
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getUShortProperty(property)));
@@ -270,7 +293,7 @@ static int getUShortProperty(lua_State *L)
 
 static int getByteProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::ByteProperty>(luaL_checkinteger(L, 2));
 
     std::byte result = edict->getByteProperty(property);
@@ -281,24 +304,45 @@ static int getByteProperty(lua_State *L)
 
 static int getEdictProperty(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto property = static_cast<Anubis::Engine::IEdict::EdictProperty>(luaL_checkinteger(L, 2));
 
-    lua_pushlightuserdata(L, edict->getEdictProperty(property).get());
+    Luna::pushEdict(L, edict->getEdictProperty(property));
     return 1;
 }
 
 static int getEdictIndex(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getIndex()));
     return 1;
 }
 
+static int getEdictFromIndex(lua_State *L)
+{
+    auto index = static_cast<std::uint32_t>(luaL_checkinteger(L, 1));
+    auto edict = gEngine->getEdict(index, Anubis::FuncCallType::Direct);
+
+    if (!edict || edict->isFree())
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Luna::pushEdict(L, edict);
+    return 1;
+}
+
+static int isValidEdict(lua_State *L)
+{
+    lua_pushboolean(L, static_cast<int>(static_cast<bool>(Luna::toEdict(L, 1))));
+    return 1;
+}
+
 static int getFixAngle(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getFixAngle()));
     return 1;
@@ -306,7 +350,7 @@ static int getFixAngle(lua_State *L)
 
 static int getModelIndex(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getModelIndex()));
     return 1;
@@ -314,7 +358,7 @@ static int getModelIndex(lua_State *L)
 
 static int getSolidType(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getSolidType()));
     return 1;
@@ -322,7 +366,7 @@ static int getSolidType(lua_State *L)
 
 static int getEffects(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getEffects()));
     return 1;
@@ -330,7 +374,7 @@ static int getEffects(lua_State *L)
 
 static int getController(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     std::array<std::byte, 4> controller = edict->getController();
 
@@ -343,7 +387,7 @@ static int getController(lua_State *L)
 
 static int getBlending(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     std::array<std::byte, 2> blending = edict->getBlending();
 
@@ -354,7 +398,7 @@ static int getBlending(lua_State *L)
 
 static int getRenderMode(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getRenderMode()));
     return 1;
@@ -362,7 +406,7 @@ static int getRenderMode(lua_State *L)
 
 static int getDeadFlag(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getDeadFlag()));
     return 1;
@@ -370,7 +414,7 @@ static int getDeadFlag(lua_State *L)
 
 static int getSpawnFlag(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     lua_pushinteger(L, static_cast<lua_Integer>(edict->getSpawnFlag()));
     return 1;
@@ -378,7 +422,7 @@ static int getSpawnFlag(lua_State *L)
 
 static int setFixAngle(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::FixAngle>(luaL_checkinteger(L, 2));
 
     edict->setFixAngle(value);
@@ -387,7 +431,7 @@ static int setFixAngle(lua_State *L)
 
 static int setModelIndex(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::PrecacheId>(luaL_checkinteger(L, 2));
 
     edict->setModelIndex(value);
@@ -396,7 +440,7 @@ static int setModelIndex(lua_State *L)
 
 static int setSolidType(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::IEdict::SolidType>(luaL_checkinteger(L, 2));
 
     edict->setSolidType(value);
@@ -405,7 +449,7 @@ static int setSolidType(lua_State *L)
 
 static int setEffects(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::IEdict::Effects>(luaL_checkinteger(L, 2));
 
     edict->setEffects(value);
@@ -414,7 +458,7 @@ static int setEffects(lua_State *L)
 
 static int setController(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     std::array<std::byte, 4> controller = {
         std::byte{static_cast<std::uint8_t>(luaL_checkinteger(L, 2))},
@@ -429,7 +473,7 @@ static int setController(lua_State *L)
 
 static int setBlending(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
 
     std::array<std::byte, 2> blending = {
         std::byte{static_cast<std::uint8_t>(luaL_checkinteger(L, 2))},
@@ -442,7 +486,7 @@ static int setBlending(lua_State *L)
 
 static int setRenderMode(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::IEdict::RenderMode>(luaL_checkinteger(L, 2));
 
     edict->setRenderMode(value);
@@ -451,7 +495,7 @@ static int setRenderMode(lua_State *L)
 
 static int setDeadFlag(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::IEdict::DeadFlag>(luaL_checkinteger(L, 2));
 
     edict->setDeadFlag(value);
@@ -460,7 +504,7 @@ static int setDeadFlag(lua_State *L)
 
 static int setSpawnFlag(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::IEdict::SpawnFlag>(luaL_checkinteger(L, 2));
 
     edict->setSpawnFlag(value);
@@ -469,13 +513,22 @@ static int setSpawnFlag(lua_State *L)
 
 static int setRenderEffects(lua_State *L)
 {
-    auto edict = reinterpret_cast<Anubis::Engine::IEdict *>(lua_touserdata(L, 1));
+    auto edict = Luna::checkEdict(L, 1);
     auto value = static_cast<Anubis::Engine::IEdict::RenderFx>(luaL_checkinteger(L, 2));
 
     edict->setRenderEffects(value);
     return 0;
 }
 
+static int getStringCacheStats(lua_State *L)
+{
+    lua_pushinteger(L, static_cast<lua_Integer>(gStringCache->getHits()));
+    lua_pushinteger(L, static_cast<lua_Integer>(gStringCache->getMisses()));
+    lua_pushinteger(L, static_cast<lua_Integer>(gStringCache->getSize()));
+
+    return 3;
+}
+
 LuaAdapterCFunction gEdictNatives[] = {
     {"setModel", setModel},
     {"setOrigin", setOrigin},
@@ -496,6 +549,7 @@ LuaAdapterCFunction gEdictNatives[] = {
     {"getFloatProperty", getFloatProperty},
     {"getIntProperty", getIntProperty},
     {"getVecProperty", getVecProperty},
+    {"getVec3Property", getVec3Property},
     {"getStrProperty", getStrProperty},
     {"getShortProperty", getShortProperty},
     {"getUShortProperty", getUShortProperty},
@@ -503,6 +557,8 @@ LuaAdapterCFunction gEdictNatives[] = {
     {"getEdictProperty", getEdictProperty},
 
     {"getEdictIndex", getEdictIndex},
+    {"getEdictFromIndex", getEdictFromIndex},
+    {"isValidEdict", isValidEdict},
     {"getFixAngle", getFixAngle},
     {"getModelIndex", getModelIndex},
     {"getSolidType", getSolidType},
@@ -524,5 +580,7 @@ LuaAdapterCFunction gEdictNatives[] = {
     {"setSpawnFlag", setSpawnFlag},
     {"setRenderEffects", setRenderEffects},
 
+    {"getStringCacheStats", getStringCacheStats},
+
     {nullptr, nullptr}
 };
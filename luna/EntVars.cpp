@@ -0,0 +1,163 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EntVars.hpp"
+#include "AnubisExports.hpp"
+
+#include <cstring>
+
+namespace
+{
+    using Luna::EntVars;
+
+    // Indexed by IEdict::FlProperty
+    constexpr std::array FL_OFFSETS {
+        offsetof(EntVars, impacttime),    offsetof(EntVars, starttime),       offsetof(EntVars, idealpitch),
+        offsetof(EntVars, ideal_yaw),     offsetof(EntVars, pitch_speed),     offsetof(EntVars, yaw_speed),
+        offsetof(EntVars, ltime),         offsetof(EntVars, nextthink),       offsetof(EntVars, gravity),
+        offsetof(EntVars, friction),      offsetof(EntVars, frame),           offsetof(EntVars, animtime),
+        offsetof(EntVars, framerate),     offsetof(EntVars, scale),           offsetof(EntVars, renderamt),
+        offsetof(EntVars, health),        offsetof(EntVars, frags),           offsetof(EntVars, takedamage),
+        offsetof(EntVars, max_health),    offsetof(EntVars, teleport_time),   offsetof(EntVars, armortype),
+        offsetof(EntVars, armorvalue),    offsetof(EntVars, dmg_take),        offsetof(EntVars, dmg_save),
+        offsetof(EntVars, dmg),           offsetof(EntVars, dmgtime),         offsetof(EntVars, speed),
+        offsetof(EntVars, air_finished),  offsetof(EntVars, pain_finished),   offsetof(EntVars, radsuit_finished),
+        offsetof(EntVars, maxspeed),      offsetof(EntVars, fov),             offsetof(EntVars, flFallVelocity),
+        offsetof(EntVars, fuser) + sizeof(float) * 0, offsetof(EntVars, fuser) + sizeof(float) * 1,
+        offsetof(EntVars, fuser) + sizeof(float) * 2, offsetof(EntVars, fuser) + sizeof(float) * 3
+    };
+
+    // Indexed by IEdict::IntProperty
+    constexpr std::array INT_OFFSETS {
+        offsetof(EntVars, skin),            offsetof(EntVars, body),        offsetof(EntVars, sequence),
+        offsetof(EntVars, gaitsequence),    offsetof(EntVars, weapons),     offsetof(EntVars, team),
+        offsetof(EntVars, waterlevel),      offsetof(EntVars, watertype),   offsetof(EntVars, playerclass),
+        offsetof(EntVars, weaponanim),      offsetof(EntVars, pushmsec),    offsetof(EntVars, bInDuck),
+        offsetof(EntVars, flTimeStepSound), offsetof(EntVars, flSwimTime),  offsetof(EntVars, flDuckTime),
+        offsetof(EntVars, iStepLeft),       offsetof(EntVars, gamestate),   offsetof(EntVars, groupinfo),
+        offsetof(EntVars, iuser) + sizeof(std::int32_t) * 0, offsetof(EntVars, iuser) + sizeof(std::int32_t) * 1,
+        offsetof(EntVars, iuser) + sizeof(std::int32_t) * 2, offsetof(EntVars, iuser) + sizeof(std::int32_t) * 3
+    };
+
+    // Indexed by IEdict::VecProperty
+    constexpr std::array VEC_OFFSETS {
+        offsetof(EntVars, origin),      offsetof(EntVars, oldorigin),      offsetof(EntVars, velocity),
+        offsetof(EntVars, basevelocity), offsetof(EntVars, clbasevelocity), offsetof(EntVars, movedir),
+        offsetof(EntVars, angles),      offsetof(EntVars, avelocity),      offsetof(EntVars, punchangle),
+        offsetof(EntVars, v_angle),     offsetof(EntVars, endpos),         offsetof(EntVars, startpos),
+        offsetof(EntVars, absmin),      offsetof(EntVars, absmax),         offsetof(EntVars, mins),
+        offsetof(EntVars, maxs),        offsetof(EntVars, size),           offsetof(EntVars, rendercolor),
+        offsetof(EntVars, view_ofs),
+        offsetof(EntVars, vuser) + sizeof(EntVars::vec3_t) * 0, offsetof(EntVars, vuser) + sizeof(EntVars::vec3_t) * 1,
+        offsetof(EntVars, vuser) + sizeof(EntVars::vec3_t) * 2, offsetof(EntVars, vuser) + sizeof(EntVars::vec3_t) * 3
+    };
+
+    // Indexed by IEdict::StrProperty
+    constexpr std::array STR_OFFSETS {
+        offsetof(EntVars, classname),   offsetof(EntVars, globalname), offsetof(EntVars, model),
+        offsetof(EntVars, viewmodel),   offsetof(EntVars, weaponmodel), offsetof(EntVars, target),
+        offsetof(EntVars, targetname),  offsetof(EntVars, netname),    offsetof(EntVars, message),
+        offsetof(EntVars, noise),       offsetof(EntVars, noise1),     offsetof(EntVars, noise2),
+        offsetof(EntVars, noise3)
+    };
+
+    using Anubis::Engine::IEdict;
+
+    static_assert(FL_OFFSETS.size() == static_cast<std::size_t>(IEdict::FlProperty::User4) + 1);
+    static_assert(INT_OFFSETS.size() == static_cast<std::size_t>(IEdict::IntProperty::User4) + 1);
+    static_assert(VEC_OFFSETS.size() == static_cast<std::size_t>(IEdict::VecProperty::User4) + 1);
+    static_assert(STR_OFFSETS.size() == static_cast<std::size_t>(IEdict::StrProperty::Noise3) + 1);
+
+    template<typename T>
+    T readField(const std::byte *vars, std::size_t offset)
+    {
+        T value;
+        std::memcpy(&value, vars + offset, sizeof(T));
+        return value;
+    }
+}
+
+namespace Luna
+{
+    EntVarsView::EntVarsView(bool enabled) : m_enabled(enabled) {}
+
+    bool EntVarsView::isEnabled() const
+    {
+        return m_enabled;
+    }
+
+    void EntVarsView::clear()
+    {
+        m_edicts.fill(nullptr);
+    }
+
+    const std::byte *EntVarsView::getVars(std::uint32_t index, std::uint32_t serialNumber)
+    {
+        if (index >= MAX_EDICTS)
+        {
+            return nullptr;
+        }
+
+        const std::byte *&cached = m_edicts[index];
+        if (!cached)
+        {
+            nstd::observer_ptr<IEdict> edict = gEngine->getEdict(index, Anubis::FuncCallType::Direct);
+
+            if (!edict)
+            {
+                return nullptr;
+            }
+
+            cached = reinterpret_cast<const std::byte *>(static_cast<edict_t *>(*edict));
+        }
+
+        if (readField<std::int32_t>(cached, offsetof(Edict, free)) ||
+            static_cast<std::uint32_t>(readField<std::int32_t>(cached, offsetof(Edict, serialnumber))) != serialNumber)
+        {
+            return nullptr;
+        }
+
+        return cached + offsetof(Edict, v);
+    }
+
+    float EntVarsView::getFloat(const std::byte *vars, IEdict::FlProperty property)
+    {
+        return readField<float>(vars, FL_OFFSETS[static_cast<std::size_t>(property)]);
+    }
+
+    std::int32_t EntVarsView::getInt(const std::byte *vars, IEdict::IntProperty property)
+    {
+        return readField<std::int32_t>(vars, INT_OFFSETS[static_cast<std::size_t>(property)]);
+    }
+
+    std::array<float, 3> EntVarsView::getVec(const std::byte *vars, IEdict::VecProperty property)
+    {
+        return readField<std::array<float, 3>>(vars, VEC_OFFSETS[static_cast<std::size_t>(property)]);
+    }
+
+    std::string_view EntVarsView::getStr(const std::byte *vars, IEdict::StrProperty property)
+    {
+        Anubis::Engine::StringOffset offset {
+            readField<EntVars::string_t>(vars, STR_OFFSETS[static_cast<std::size_t>(property)])};
+
+        return gEngine->getString(offset, Anubis::FuncCallType::Direct);
+    }
+}
+
+std::unique_ptr<Luna::EntVarsView> gEntVarsView;
@@ -0,0 +1,216 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <observer_ptr.hpp>
+#include <engine/IEdict.hpp>
+
+#include <array>
+#include <cinttypes>
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace Luna
+{
+    /**
+     * @brief Mirror of the engine's entvars_t layout.
+     *
+     * Only used to compute field offsets, entity memory is never accessed
+     * through this type. Must match progdefs.h from the HLSDK.
+     */
+    struct EntVars
+    {
+        using vec3_t = std::array<float, 3>;
+        using string_t = std::uint32_t;
+
+        string_t classname;
+        string_t globalname;
+        vec3_t origin;
+        vec3_t oldorigin;
+        vec3_t velocity;
+        vec3_t basevelocity;
+        vec3_t clbasevelocity;
+        vec3_t movedir;
+        vec3_t angles;
+        vec3_t avelocity;
+        vec3_t punchangle;
+        vec3_t v_angle;
+        vec3_t endpos;
+        vec3_t startpos;
+        float impacttime;
+        float starttime;
+        std::int32_t fixangle;
+        float idealpitch;
+        float pitch_speed;
+        float ideal_yaw;
+        float yaw_speed;
+        std::int32_t modelindex;
+        string_t model;
+        string_t viewmodel;
+        string_t weaponmodel;
+        vec3_t absmin;
+        vec3_t absmax;
+        vec3_t mins;
+        vec3_t maxs;
+        vec3_t size;
+        float ltime;
+        float nextthink;
+        std::int32_t movetype;
+        std::int32_t solid;
+        std::int32_t skin;
+        std::int32_t body;
+        std::int32_t effects;
+        float gravity;
+        float friction;
+        std::int32_t light_level;
+        std::int32_t sequence;
+        std::int32_t gaitsequence;
+        float frame;
+        float animtime;
+        float framerate;
+        std::array<std::uint8_t, 4> controller;
+        std::array<std::uint8_t, 2> blending;
+        float scale;
+        std::int32_t rendermode;
+        float renderamt;
+        vec3_t rendercolor;
+        std::int32_t renderfx;
+        float health;
+        float frags;
+        std::int32_t weapons;
+        float takedamage;
+        std::int32_t deadflag;
+        vec3_t view_ofs;
+        std::int32_t button;
+        std::int32_t impulse;
+        void *chain;
+        void *dmg_inflictor;
+        void *enemy;
+        void *aiment;
+        void *owner;
+        void *groundentity;
+        std::int32_t spawnflags;
+        std::int32_t flags;
+        std::int32_t colormap;
+        std::int32_t team;
+        float max_health;
+        float teleport_time;
+        float armortype;
+        float armorvalue;
+        std::int32_t waterlevel;
+        std::int32_t watertype;
+        string_t target;
+        string_t targetname;
+        string_t netname;
+        string_t message;
+        float dmg_take;
+        float dmg_save;
+        float dmg;
+        float dmgtime;
+        string_t noise;
+        string_t noise1;
+        string_t noise2;
+        string_t noise3;
+        float speed;
+        float air_finished;
+        float pain_finished;
+        float radsuit_finished;
+        void *pContainingEntity;
+        std::int32_t playerclass;
+        float maxspeed;
+        float fov;
+        std::int32_t weaponanim;
+        std::int32_t pushmsec;
+        std::int32_t bInDuck;
+        std::int32_t flTimeStepSound;
+        std::int32_t flSwimTime;
+        std::int32_t flDuckTime;
+        std::int32_t iStepLeft;
+        float flFallVelocity;
+        std::int32_t gamestate;
+        std::int32_t oldbuttons;
+        std::int32_t groupinfo;
+        std::array<std::int32_t, 4> iuser;
+        std::array<float, 4> fuser;
+        std::array<vec3_t, 4> vuser;
+        std::array<void *, 4> euser;
+    };
+
+    static_assert(sizeof(void *) != 4 || sizeof(EntVars) == 676, "EntVars does not match entvars_t");
+
+    /**
+     * @brief Mirror of the engine's edict_t layout.
+     *
+     * Same as EntVars, only used for offsets. Must match edict.h from the HLSDK.
+     */
+    struct Edict
+    {
+        std::int32_t free;
+        std::int32_t serialnumber;
+        std::array<void *, 2> area;
+        std::int32_t headnode;
+        std::int32_t num_leafs;
+        std::array<std::int16_t, 48> leafnums;
+        float freetime;
+        void *pvPrivateData;
+        EntVars v;
+    };
+
+    static_assert(sizeof(void *) != 4 || sizeof(Edict) == 804, "Edict does not match edict_t");
+
+    /**
+     * @brief Reads entity fields straight from entvars_t.
+     *
+     * Field offsets are resolved once per property id, so a read is a table
+     * lookup and a load instead of a virtual call with a switch behind it.
+     * The edict_t pointer of each slot is looked up through IEdict once and
+     * cached until the next map, handles are then validated against its free
+     * and serialnumber fields without calling into the engine at all.
+     * Only reads are served, writes keep going through the IEdict setters.
+     */
+    class EntVarsView
+    {
+    public:
+        static constexpr std::uint32_t MAX_EDICTS = 2048;
+
+    public:
+        explicit EntVarsView(bool enabled);
+
+        [[nodiscard]] bool isEnabled() const;
+        void clear();
+
+        // entvars_t of a live edict, nullptr if the handle's edict was freed or reused
+        [[nodiscard]] const std::byte *getVars(std::uint32_t index, std::uint32_t serialNumber);
+
+        [[nodiscard]] static float getFloat(const std::byte *vars, Anubis::Engine::IEdict::FlProperty property);
+        [[nodiscard]] static std::int32_t getInt(const std::byte *vars, Anubis::Engine::IEdict::IntProperty property);
+        [[nodiscard]] static std::array<float, 3> getVec(const std::byte *vars,
+                                                         Anubis::Engine::IEdict::VecProperty property);
+        [[nodiscard]] static std::string_view getStr(const std::byte *vars,
+                                                     Anubis::Engine::IEdict::StrProperty property);
+
+    private:
+        std::array<const std::byte *, MAX_EDICTS> m_edicts{};
+        bool m_enabled;
+    };
+}
+
+extern std::unique_ptr<Luna::EntVarsView> gEntVarsView;
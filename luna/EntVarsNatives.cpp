@@ -0,0 +1,210 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EntVarsNatives.hpp"
+#include "EntVars.hpp"
+#include "EntityHandle.hpp"
+#include "Vec3Natives.hpp"
+
+using Anubis::Engine::IEdict;
+
+template<typename T>
+static T checkProperty(lua_State *L, int arg, T last)
+{
+    lua_Integer property = luaL_checkinteger(L, arg);
+    luaL_argcheck(L, property >= 0 && property <= static_cast<lua_Integer>(last), arg, "invalid property");
+
+    return static_cast<T>(property);
+}
+
+// entvars_t of the handle at arg, nullptr if it is invalid or stale
+static const std::byte *toVars(lua_State *L, int arg)
+{
+    std::uint32_t index;
+    std::uint32_t serialNumber;
+
+    if (!Luna::toEdictHandle(L, arg, index, serialNumber))
+    {
+        return nullptr;
+    }
+
+    return gEntVarsView->getVars(index, serialNumber);
+}
+
+static const std::byte *checkVars(lua_State *L, int arg)
+{
+    const std::byte *vars = toVars(L, arg);
+
+    if (!vars)
+    {
+        luaL_argerror(L, arg, "invalid or stale entity handle");
+    }
+
+    return vars;
+}
+
+static int getFloatField(lua_State *L)
+{
+    auto property = checkProperty(L, 2, IEdict::FlProperty::User4);
+
+    if (!gEntVarsView->isEnabled())
+    {
+        lua_pushnumber(L, Luna::checkEdict(L, 1)->getFlProperty(property));
+        return 1;
+    }
+
+    lua_pushnumber(L, Luna::EntVarsView::getFloat(checkVars(L, 1), property));
+    return 1;
+}
+
+static int getIntField(lua_State *L)
+{
+    auto property = checkProperty(L, 2, IEdict::IntProperty::User4);
+
+    if (!gEntVarsView->isEnabled())
+    {
+        lua_pushinteger(L, Luna::checkEdict(L, 1)->getIntProperty(property));
+        return 1;
+    }
+
+    lua_pushinteger(L, Luna::EntVarsView::getInt(checkVars(L, 1), property));
+    return 1;
+}
+
+// getVecField(edict, property [, out]), fills the Vec3 passed as out instead of allocating a new one
+static int getVecField(lua_State *L)
+{
+    auto property = checkProperty(L, 2, IEdict::VecProperty::User4);
+
+    std::array<float, 3> result = gEntVarsView->isEnabled()
+                                      ? Luna::EntVarsView::getVec(checkVars(L, 1), property)
+                                      : Luna::checkEdict(L, 1)->getVecProperty(property);
+
+    if (Luna::Vec3 *out = Luna::toVec3(L, 3))
+    {
+        out->x = result[0];
+        out->y = result[1];
+        out->z = result[2];
+        lua_pushvalue(L, 3);
+        return 1;
+    }
+
+    Luna::pushVec3(L, result);
+    return 1;
+}
+
+static int getStrField(lua_State *L)
+{
+    auto property = checkProperty(L, 2, IEdict::StrProperty::Noise3);
+
+    std::string_view value;
+
+    if (gEntVarsView->isEnabled())
+    {
+        value = Luna::EntVarsView::getStr(checkVars(L, 1), property);
+    }
+    else
+    {
+        value = gEngine->getString(Luna::checkEdict(L, 1)->getStrProperty(property), Anubis::FuncCallType::Direct);
+    }
+
+    lua_pushlstring(L, value.data(), value.length());
+    return 1;
+}
+
+// getFloatFields(edicts, property [, out]), reads one float field of every entity, false for invalid handles
+static int getFloatFields(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    auto property = checkProperty(L, 2, IEdict::FlProperty::User4);
+    auto count = static_cast<lua_Integer>(lua_rawlen(L, 1));
+    bool direct = gEntVarsView->isEnabled();
+
+    lua_Integer oldLength = 0;
+
+    if (lua_istable(L, 3))
+    {
+        lua_pushvalue(L, 3);
+        oldLength = static_cast<lua_Integer>(lua_rawlen(L, -1));
+    }
+    else
+    {
+        lua_createtable(L, static_cast<int>(count), 0);
+    }
+
+    for (lua_Integer i = 1; i <= count; i++)
+    {
+        lua_rawgeti(L, 1, i);
+
+        if (direct)
+        {
+            const std::byte *vars = toVars(L, -1);
+            lua_pop(L, 1);
+
+            if (vars)
+            {
+                lua_pushnumber(L, Luna::EntVarsView::getFloat(vars, property));
+            }
+            else
+            {
+                lua_pushboolean(L, false);
+            }
+        }
+        else
+        {
+            nstd::observer_ptr<IEdict> edict = Luna::toEdict(L, -1);
+            lua_pop(L, 1);
+
+            if (edict)
+            {
+                lua_pushnumber(L, edict->getFlProperty(property));
+            }
+            else
+            {
+                lua_pushboolean(L, false);
+            }
+        }
+
+        lua_rawseti(L, -2, i);
+    }
+
+    for (lua_Integer i = count + 1; i <= oldLength; i++)
+    {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+
+    return 1;
+}
+
+static int isDirectFieldAccess(lua_State *L)
+{
+    lua_pushboolean(L, gEntVarsView->isEnabled());
+    return 1;
+}
+
+LuaAdapterCFunction gEntVarsNatives[] = {
+    {"getFloatField", getFloatField},
+    {"getIntField", getIntField},
+    {"getVecField", getVecField},
+    {"getStrField", getStrField},
+    {"getFloatFields", getFloatFields},
+    {"isDirectFieldAccess", isDirectFieldAccess},
+    {nullptr, nullptr}
+};
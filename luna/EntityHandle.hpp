@@ -0,0 +1,106 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "CommonNatives.hpp"
+#include "AnubisExports.hpp"
+
+#include <engine/IEdict.hpp>
+
+namespace Luna
+{
+    /*
+     * Entities are passed to Lua as integers packing the serial number above
+     * the edict index. A handle stays comparable and usable as a table key, and
+     * resolving it fails once the edict is freed or reused.
+     */
+    constexpr int EDICT_HANDLE_INDEX_BITS = 16;
+    constexpr lua_Integer EDICT_HANDLE_INDEX_MASK = (lua_Integer(1) << EDICT_HANDLE_INDEX_BITS) - 1;
+
+    inline lua_Integer makeEdictHandle(std::uint32_t index, std::uint32_t serialNumber)
+    {
+        return (static_cast<lua_Integer>(serialNumber) << EDICT_HANDLE_INDEX_BITS) | static_cast<lua_Integer>(index);
+    }
+
+    inline lua_Integer makeEdictHandle(nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        return makeEdictHandle(edict->getIndex(), edict->getSerialNumber());
+    }
+
+    inline void pushEdict(lua_State *L, nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        if (!edict)
+        {
+            lua_pushnil(L);
+            return;
+        }
+
+        lua_pushinteger(L, makeEdictHandle(edict));
+    }
+
+    // Splits a handle at arg into edict index and serial number, false if it is not a handle
+    inline bool toEdictHandle(lua_State *L, int arg, std::uint32_t &index, std::uint32_t &serialNumber)
+    {
+        int isInteger;
+        lua_Integer handle = lua_tointegerx(L, arg, &isInteger);
+
+        if (!isInteger || handle < 0)
+        {
+            return false;
+        }
+
+        index = static_cast<std::uint32_t>(handle & EDICT_HANDLE_INDEX_MASK);
+        serialNumber = static_cast<std::uint32_t>(handle >> EDICT_HANDLE_INDEX_BITS);
+
+        return true;
+    }
+
+    inline nstd::observer_ptr<Anubis::Engine::IEdict> toEdict(lua_State *L, int arg)
+    {
+        std::uint32_t index;
+        std::uint32_t serialNumber;
+
+        if (!toEdictHandle(L, arg, index, serialNumber))
+        {
+            return {};
+        }
+
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict = gEngine->getEdict(index, Anubis::FuncCallType::Direct);
+
+        if (!edict || edict->isFree() || edict->getSerialNumber() != serialNumber)
+        {
+            return {};
+        }
+
+        return edict;
+    }
+
+    inline nstd::observer_ptr<Anubis::Engine::IEdict> checkEdict(lua_State *L, int arg)
+    {
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict = toEdict(L, arg);
+
+        if (!edict)
+        {
+            luaL_argerror(L, arg, "invalid or stale entity handle");
+        }
+
+        return edict;
+    }
+}
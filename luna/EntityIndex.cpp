@@ -0,0 +1,230 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EntityIndex.hpp"
+#include "AnubisExports.hpp"
+#include "ClassHandler.hpp"
+#include "SpatialIndex.hpp"
+
+#include <engine/IEdict.hpp>
+
+namespace Luna
+{
+    void forgetEntity(std::uint32_t index)
+    {
+        gSpatialIndex->remove(index);
+        gEntityIndex->remove(index);
+        gClassHandler.invalidate(index);
+    }
+
+    void removeEntity(nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        forgetEntity(edict->getIndex());
+        gEngine->removeEntity(edict, Anubis::FuncCallType::Direct);
+    }
+
+    void NameIndex::insert(std::uint32_t index, std::string_view name)
+    {
+        auto [it, inserted] = m_lookup.try_emplace(name, static_cast<std::uint32_t>(m_buckets.size()));
+        if (inserted)
+        {
+            m_buckets.push_back({name, {}});
+        }
+
+        Bucket &bucket = m_buckets[it->second];
+        Link &link = m_links[index];
+
+        link.bucket = static_cast<std::int32_t>(it->second);
+        link.slot = static_cast<std::uint32_t>(bucket.edicts.size());
+
+        bucket.edicts.push_back(static_cast<std::uint16_t>(index));
+    }
+
+    void NameIndex::erase(std::uint32_t index)
+    {
+        Link &link = m_links[index];
+        if (link.bucket < 0)
+        {
+            return;
+        }
+
+        auto &edicts = m_buckets[static_cast<std::size_t>(link.bucket)].edicts;
+        std::uint16_t last = edicts.back();
+
+        edicts[link.slot] = last;
+        m_links[last].slot = link.slot;
+        edicts.pop_back();
+
+        link.bucket = -1;
+    }
+
+    void NameIndex::clear()
+    {
+        m_lookup.clear();
+        m_buckets.clear();
+        m_links.fill({});
+    }
+
+    std::string_view NameIndex::getName(std::uint32_t index) const
+    {
+        const Link &link = m_links[index];
+        if (link.bucket < 0)
+        {
+            return {};
+        }
+
+        return m_buckets[static_cast<std::size_t>(link.bucket)].name;
+    }
+
+    std::int32_t NameIndex::findBucket(std::string_view name) const
+    {
+        auto it = m_lookup.find(name);
+        if (it == m_lookup.end())
+        {
+            return -1;
+        }
+
+        return static_cast<std::int32_t>(it->second);
+    }
+
+    const std::vector<NameIndex::Bucket> &NameIndex::getBuckets() const
+    {
+        return m_buckets;
+    }
+
+    EntityIndex::EntityIndex()
+    {
+        m_dirty.reserve(MAX_EDICTS);
+    }
+
+    void EntityIndex::rebuild()
+    {
+        clear();
+
+        for (std::uint32_t i = 1; i < MAX_EDICTS; i++)
+        {
+            sync(i);
+        }
+    }
+
+    void EntityIndex::clear()
+    {
+        m_classNames.clear();
+        m_targetNames.clear();
+        m_dirtyFlags.fill(false);
+        m_dirty.clear();
+        m_generation++;
+    }
+
+    void EntityIndex::update()
+    {
+        for (std::uint16_t index : m_dirty)
+        {
+            // Removed after it was marked
+            if (!m_dirtyFlags[index])
+            {
+                continue;
+            }
+
+            m_dirtyFlags[index] = false;
+            sync(index);
+        }
+
+        m_dirty.clear();
+    }
+
+    void EntityIndex::markDirty(std::uint32_t index)
+    {
+        if (!index || index >= MAX_EDICTS || m_dirtyFlags[index])
+        {
+            return;
+        }
+
+        m_dirtyFlags[index] = true;
+        m_dirty.push_back(static_cast<std::uint16_t>(index));
+    }
+
+    void EntityIndex::remove(std::uint32_t index)
+    {
+        if (!index || index >= MAX_EDICTS)
+        {
+            return;
+        }
+
+        m_classNames.erase(index);
+        m_targetNames.erase(index);
+        m_dirtyFlags[index] = false;
+    }
+
+    void EntityIndex::sync(std::uint32_t index)
+    {
+        using Anubis::Engine::IEdict;
+
+        if (!index || index >= MAX_EDICTS)
+        {
+            return;
+        }
+
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(index, Anubis::FuncCallType::Direct);
+
+        if (!edict || edict->isFree())
+        {
+            remove(index);
+            return;
+        }
+
+        std::string_view className = gEngine->getString(edict->getStrProperty(IEdict::StrProperty::ClassName),
+                                                        Anubis::FuncCallType::Direct);
+
+        if (className != m_classNames.getName(index))
+        {
+            m_classNames.erase(index);
+
+            if (!className.empty())
+            {
+                m_classNames.insert(index, className);
+            }
+        }
+
+        std::string_view targetName = gEngine->getString(edict->getStrProperty(IEdict::StrProperty::TargetName),
+                                                         Anubis::FuncCallType::Direct);
+
+        if (targetName != m_targetNames.getName(index))
+        {
+            m_targetNames.erase(index);
+
+            if (!targetName.empty())
+            {
+                m_targetNames.insert(index, targetName);
+            }
+        }
+    }
+
+    const NameIndex &EntityIndex::getIndex(Field field) const
+    {
+        return field == Field::ClassName ? m_classNames : m_targetNames;
+    }
+
+    std::uint32_t EntityIndex::getGeneration() const
+    {
+        return m_generation;
+    }
+}
+
+std::unique_ptr<Luna::EntityIndex> gEntityIndex;
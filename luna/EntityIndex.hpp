@@ -0,0 +1,123 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <observer_ptr.hpp>
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Anubis::Engine
+{
+    class IEdict;
+}
+
+namespace Luna
+{
+    // Drops the edict from every per-entity structure kept by Luna
+    void forgetEntity(std::uint32_t index);
+    // Forgets the entity and removes it from the engine
+    void removeEntity(nstd::observer_ptr<Anubis::Engine::IEdict> edict);
+
+    /**
+     * @brief Maps a string entity field to the dense list of edict indices carrying it.
+     *
+     * Keys are views into engine-owned strings, so the index must be cleared on map change.
+     * Buckets are never erased until then, which keeps bucket ids stable for iterators.
+     */
+    class NameIndex
+    {
+    public:
+        static constexpr std::uint32_t MAX_EDICTS = 2048;
+
+        struct Bucket
+        {
+            std::string_view name;
+            std::vector<std::uint16_t> edicts;
+        };
+
+    public:
+        void insert(std::uint32_t index, std::string_view name);
+        void erase(std::uint32_t index);
+        void clear();
+
+        [[nodiscard]] std::string_view getName(std::uint32_t index) const;
+        [[nodiscard]] std::int32_t findBucket(std::string_view name) const;
+        [[nodiscard]] const std::vector<Bucket> &getBuckets() const;
+
+    private:
+        struct Link
+        {
+            std::int32_t bucket = -1;
+            std::uint32_t slot = 0;
+        };
+
+    private:
+        std::unordered_map<std::string_view, std::uint32_t> m_lookup;
+        std::vector<Bucket> m_buckets;
+        std::array<Link, MAX_EDICTS> m_links{};
+    };
+
+    /**
+     * @brief Classname and targetname indexes over live edicts.
+     *
+     * Rebuilt on serverActivate, entities created or given private data are
+     * queued and linked on the next update, removed ones are unlinked at once.
+     * Names changed by the game dll directly are picked up when iteration
+     * runs into a stale entry.
+     */
+    class EntityIndex
+    {
+    public:
+        static constexpr std::uint32_t MAX_EDICTS = NameIndex::MAX_EDICTS;
+
+        enum class Field : std::uint8_t
+        {
+            ClassName = 0,
+            TargetName
+        };
+
+    public:
+        EntityIndex();
+
+        void rebuild();
+        void clear();
+        void update();
+        void markDirty(std::uint32_t index);
+        void remove(std::uint32_t index);
+        void sync(std::uint32_t index);
+
+        [[nodiscard]] const NameIndex &getIndex(Field field) const;
+        [[nodiscard]] std::uint32_t getGeneration() const;
+
+    private:
+        NameIndex m_classNames;
+        NameIndex m_targetNames;
+        std::array<bool, MAX_EDICTS> m_dirtyFlags{};
+        std::vector<std::uint16_t> m_dirty;
+        std::uint32_t m_generation{};
+    };
+}
+
+extern std::unique_ptr<Luna::EntityIndex> gEntityIndex;
@@ -0,0 +1,167 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EntityIndexNatives.hpp"
+#include "EntityIndex.hpp"
+#include "AnubisExports.hpp"
+#include "EntityHandle.hpp"
+
+#include <engine/IEdict.hpp>
+
+#include <string_view>
+
+struct EntityIterator
+{
+    Luna::EntityIndex::Field field;
+    bool prefix;
+    bool started;
+    std::uint32_t generation;
+    std::uint32_t bucket;
+    std::uint32_t position;
+};
+
+static bool matchesName(std::string_view name, std::string_view pattern, bool prefix)
+{
+    return prefix ? name.substr(0, pattern.size()) == pattern : name == pattern;
+}
+
+// Walks buckets backwards so removing the yielded entity inside the loop does not skip any other
+static int entityIteratorNext(lua_State *L)
+{
+    using Anubis::Engine::IEdict;
+
+    auto it = reinterpret_cast<EntityIterator *>(lua_touserdata(L, lua_upvalueindex(1)));
+
+    size_t length;
+    const char *patternStr = lua_tolstring(L, lua_upvalueindex(2), &length);
+    std::string_view pattern {patternStr, length};
+
+    if (it->generation != gEntityIndex->getGeneration())
+    {
+        return 0;
+    }
+
+    const Luna::NameIndex &index = gEntityIndex->getIndex(it->field);
+    const auto &buckets = index.getBuckets();
+
+    while (it->bucket < buckets.size())
+    {
+        const auto &bucket = buckets[it->bucket];
+
+        if (!it->started)
+        {
+            if (!matchesName(bucket.name, pattern, it->prefix))
+            {
+                it->bucket++;
+                continue;
+            }
+
+            it->started = true;
+            it->position = static_cast<std::uint32_t>(bucket.edicts.size());
+        }
+
+        if (it->position > bucket.edicts.size())
+        {
+            it->position = static_cast<std::uint32_t>(bucket.edicts.size());
+        }
+
+        if (!it->position)
+        {
+            if (!it->prefix)
+            {
+                break;
+            }
+
+            it->started = false;
+            it->bucket++;
+            continue;
+        }
+
+        std::uint16_t edictIndex = bucket.edicts[--it->position];
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(edictIndex, Anubis::FuncCallType::Direct);
+
+        auto property = it->field == Luna::EntityIndex::Field::ClassName ? IEdict::StrProperty::ClassName
+                                                                         : IEdict::StrProperty::TargetName;
+
+        if (!edict || edict->isFree() ||
+            gEngine->getString(edict->getStrProperty(property), Anubis::FuncCallType::Direct) != bucket.name)
+        {
+            // Stale entry, the entity was freed or renamed without going through the hooks.
+            // Resyncing may relink it into another bucket, so the bucket is looked up again.
+            gEntityIndex->sync(edictIndex);
+            continue;
+        }
+
+        Luna::pushEdict(L, edict);
+        return 1;
+    }
+
+    it->bucket = static_cast<std::uint32_t>(buckets.size());
+    return 0;
+}
+
+static int pushEntityIterator(lua_State *L, Luna::EntityIndex::Field field)
+{
+    size_t length;
+    const char *name = luaL_checklstring(L, 1, &length);
+
+    gEntityIndex->update();
+
+    std::string_view pattern {name, length};
+    bool prefix = !pattern.empty() && pattern.back() == '*';
+    if (prefix)
+    {
+        pattern.remove_suffix(1);
+    }
+
+    auto it = reinterpret_cast<EntityIterator *>(lua_newuserdatauv(L, sizeof(EntityIterator), 0));
+    it->field = field;
+    it->prefix = prefix;
+    it->started = false;
+    it->generation = gEntityIndex->getGeneration();
+    it->bucket = 0;
+    it->position = 0;
+
+    if (!prefix)
+    {
+        std::int32_t bucket = gEntityIndex->getIndex(field).findBucket(pattern);
+        it->bucket = bucket < 0 ? static_cast<std::uint32_t>(-1) : static_cast<std::uint32_t>(bucket);
+    }
+
+    lua_pushlstring(L, pattern.data(), pattern.size());
+    lua_pushcclosure(L, entityIteratorNext, 2);
+
+    return 1;
+}
+
+static int findByClassName(lua_State *L)
+{
+    return pushEntityIterator(L, Luna::EntityIndex::Field::ClassName);
+}
+
+static int findByTargetName(lua_State *L)
+{
+    return pushEntityIterator(L, Luna::EntityIndex::Field::TargetName);
+}
+
+LuaAdapterCFunction gEntityIndexNatives[] = {
+    {"findByClassName", findByClassName},
+    {"findByTargetName", findByTargetName},
+    {nullptr, nullptr}
+};
@@ -0,0 +1,226 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EntityPool.hpp"
+#include "AnubisExports.hpp"
+#include "EntityIndex.hpp"
+#include "SpatialIndex.hpp"
+#include "StringCache.hpp"
+
+namespace Luna
+{
+    EntityPool::EntityPool(std::size_t maxPerPlugin) : m_maxPerPlugin(maxPerPlugin) {}
+
+    nstd::observer_ptr<Anubis::Engine::IEdict> EntityPool::acquire(lua_State *L, std::string_view className)
+    {
+        PluginPool &pool = m_pools[L];
+        Anubis::Engine::StringOffset classNameOffset = gStringCache->alloc(className);
+        auto iter = pool.entities.find(classNameOffset);
+
+        while (iter != pool.entities.end() && !iter->second.empty())
+        {
+            Parked parked = iter->second.back();
+            iter->second.pop_back();
+            pool.parked--;
+
+            // Skip entities removed behind our back (map logic, other plugins)
+            nstd::observer_ptr<Anubis::Engine::IEdict> edict = _getParked(parked);
+            if (!edict)
+            {
+                continue;
+            }
+
+            _reset(edict);
+            _handOut(L, edict);
+
+            // Visible to lookups again
+            gEntityIndex->markDirty(parked.index);
+            gSpatialIndex->markDirty(parked.index);
+            pool.hits++;
+
+            return edict;
+        }
+
+        pool.misses++;
+
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict =
+            gEngine->createNamedEntity(classNameOffset, Anubis::FuncCallType::Direct);
+
+        if (edict)
+        {
+            _handOut(L, edict);
+        }
+
+        return edict;
+    }
+
+    EntityPool::Release EntityPool::release(lua_State *L, nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        using Anubis::Engine::IEdict;
+
+        // Players, the world and map entities never came from acquire(), neither did parked ones
+        if (!_isHandedOut(L, edict) ||
+            static_cast<std::uint32_t>(edict->getFlags()) & static_cast<std::uint32_t>(IEdict::Flag::WorldBrush))
+        {
+            return Release::Rejected;
+        }
+
+        std::uint32_t index = edict->getIndex();
+        m_handedOut[index] = {};
+
+        PluginPool &pool = m_pools[L];
+        std::string_view className =
+            gEngine->getString(edict->getStrProperty(IEdict::StrProperty::ClassName), Anubis::FuncCallType::Direct);
+
+        if (pool.parked >= m_maxPerPlugin || className.empty())
+        {
+            removeEntity(edict);
+            return Release::Removed;
+        }
+
+        _park(edict);
+
+        pool.entities[gStringCache->alloc(className)].push_back(
+            {static_cast<std::uint16_t>(index), edict->getSerialNumber()});
+        pool.parked++;
+
+        return Release::Parked;
+    }
+
+    void EntityPool::drop(lua_State *L)
+    {
+        for (HandedOut &handedOut : m_handedOut)
+        {
+            if (handedOut.owner == L)
+            {
+                handedOut = {};
+            }
+        }
+
+        auto iter = m_pools.find(L);
+        if (iter == m_pools.end())
+        {
+            return;
+        }
+
+        for (const auto &[className, entities] : iter->second.entities)
+        {
+            for (const Parked &parked : entities)
+            {
+                nstd::observer_ptr<Anubis::Engine::IEdict> edict = _getParked(parked);
+                if (!edict)
+                {
+                    continue;
+                }
+
+                removeEntity(edict);
+            }
+        }
+
+        m_pools.erase(iter);
+    }
+
+    void EntityPool::clear()
+    {
+        // Engine frees every entity on map change, keep only the counters
+        for (auto &[L, pool] : m_pools)
+        {
+            pool.entities.clear();
+            pool.parked = 0;
+        }
+
+        m_handedOut.fill({});
+    }
+
+    EntityPool::Stats EntityPool::getStats(lua_State *L) const
+    {
+        auto iter = m_pools.find(L);
+        if (iter == m_pools.end())
+        {
+            return {};
+        }
+
+        return {iter->second.hits, iter->second.misses, iter->second.parked};
+    }
+
+    nstd::observer_ptr<Anubis::Engine::IEdict> EntityPool::_getParked(const Parked &parked)
+    {
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict = gEngine->getEdict(parked.index, Anubis::FuncCallType::Direct);
+
+        if (!edict || edict->isFree() || edict->getSerialNumber() != parked.serialNumber)
+        {
+            return nullptr;
+        }
+
+        return edict;
+    }
+
+    bool EntityPool::_isHandedOut(lua_State *L, nstd::observer_ptr<Anubis::Engine::IEdict> edict) const
+    {
+        std::uint32_t index = edict->getIndex();
+
+        return index > gEngine->getMaxClients() && index < MAX_EDICTS && m_handedOut[index].owner == L &&
+               m_handedOut[index].serialNumber == edict->getSerialNumber();
+    }
+
+    void EntityPool::_handOut(lua_State *L, nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        if (std::uint32_t index = edict->getIndex(); index < MAX_EDICTS)
+        {
+            m_handedOut[index] = {L, edict->getSerialNumber()};
+        }
+    }
+
+    void EntityPool::_park(nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        using Anubis::Engine::IEdict;
+
+        edict->setEffects(IEdict::Effects::NoDraw);
+        edict->setSolidType(IEdict::SolidType::Not);
+        edict->setMoveType(IEdict::MoveType::None);
+        edict->setVecProperty(IEdict::VecProperty::Velocity, {});
+        edict->setVecProperty(IEdict::VecProperty::AVelocity, {});
+        edict->setFlProperty(IEdict::FlProperty::NextThink, 0.0f);
+
+        // Relink so the engine drops it from the solid area lists
+        gEngine->setOrigin(edict, edict->getVecProperty(IEdict::VecProperty::Origin), Anubis::FuncCallType::Direct);
+
+        // Lookups of other plugins must not find it while it is parked
+        gEntityIndex->remove(edict->getIndex());
+        gSpatialIndex->remove(edict->getIndex());
+    }
+
+    void EntityPool::_reset(nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        using Anubis::Engine::IEdict;
+
+        edict->setEffects(IEdict::Effects::None);
+        edict->setRenderMode(IEdict::RenderMode::Normal);
+        edict->setRenderEffects(IEdict::RenderFx::None);
+        edict->setFlProperty(IEdict::FlProperty::RenderAmount, 0.0f);
+        edict->setFlProperty(IEdict::FlProperty::Frame, 0.0f);
+        edict->setFlProperty(IEdict::FlProperty::AnimTime, 0.0f);
+        edict->setFlProperty(IEdict::FlProperty::Scale, 0.0f);
+        edict->setEdictProperty(IEdict::EdictProperty::Owner, nullptr);
+        edict->setEdictProperty(IEdict::EdictProperty::Aiment, nullptr);
+        edict->setEdictProperty(IEdict::EdictProperty::Enemy, nullptr);
+    }
+}
+
+std::unique_ptr<Luna::EntityPool> gEntityPool;
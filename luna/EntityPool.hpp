@@ -0,0 +1,115 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <observer_ptr.hpp>
+#include <engine/IEdict.hpp>
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+namespace Luna
+{
+    /**
+     * @brief Per-plugin pool of parked temporary entities.
+     *
+     * Released entities are hidden (NoDraw, not solid, not moving) and taken
+     * out of the entity and spatial indexes instead of being removed. They are
+     * handed back by acquire() for the same classname with their transient
+     * state reset. Only entities a plugin got from acquire() can be released
+     * by it. Each plugin may park at most a configured number of entities,
+     * anything above that is removed as usual.
+     */
+    class EntityPool
+    {
+    public:
+        static constexpr std::uint32_t MAX_EDICTS = 2048;
+
+        enum class Release : std::uint8_t
+        {
+            Parked = 0,
+            // Pool of the plugin is full
+            Removed,
+            // Not an entity the plugin acquired
+            Rejected
+        };
+
+        struct Stats
+        {
+            std::uint64_t hits;
+            std::uint64_t misses;
+            std::size_t parked;
+        };
+
+    public:
+        explicit EntityPool(std::size_t maxPerPlugin);
+
+        // Reuses a parked entity or creates a new one
+        [[nodiscard]] nstd::observer_ptr<Anubis::Engine::IEdict> acquire(lua_State *L, std::string_view className);
+        Release release(lua_State *L, nstd::observer_ptr<Anubis::Engine::IEdict> edict);
+        void drop(lua_State *L);
+        void clear();
+
+        [[nodiscard]] Stats getStats(lua_State *L) const;
+
+    private:
+        struct Parked
+        {
+            std::uint16_t index;
+            std::uint32_t serialNumber;
+        };
+
+        struct HandedOut
+        {
+            lua_State *owner;
+            std::uint32_t serialNumber;
+        };
+
+        struct PluginPool
+        {
+            // Keyed by the interned classname offset
+            std::unordered_map<std::uint32_t, std::vector<Parked>> entities;
+            std::size_t parked;
+            std::uint64_t hits;
+            std::uint64_t misses;
+        };
+
+    private:
+        [[nodiscard]] static nstd::observer_ptr<Anubis::Engine::IEdict> _getParked(const Parked &parked);
+        [[nodiscard]] bool _isHandedOut(lua_State *L, nstd::observer_ptr<Anubis::Engine::IEdict> edict) const;
+        void _handOut(lua_State *L, nstd::observer_ptr<Anubis::Engine::IEdict> edict);
+        static void _park(nstd::observer_ptr<Anubis::Engine::IEdict> edict);
+        static void _reset(nstd::observer_ptr<Anubis::Engine::IEdict> edict);
+
+    private:
+        std::unordered_map<lua_State *, PluginPool> m_pools;
+        // Plugin each edict was acquired by, the serial number tells a reused edict apart
+        std::array<HandedOut, MAX_EDICTS> m_handedOut{};
+        std::size_t m_maxPerPlugin;
+    };
+}
+
+extern std::unique_ptr<Luna::EntityPool> gEntityPool;
@@ -0,0 +1,72 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "EntityPoolNatives.hpp"
+#include "EntityHandle.hpp"
+#include "EntityIndex.hpp"
+#include "EntityPool.hpp"
+
+#include <engine/IEdict.hpp>
+
+// acquireEntity(className), reuses a parked entity or creates a new one
+static int acquireEntity(lua_State *L)
+{
+    size_t length;
+    const char *name = luaL_checklstring(L, 1, &length);
+
+    nstd::observer_ptr<Anubis::Engine::IEdict> edict = gEntityPool->acquire(Luna::getMainThread(L), {name, length});
+
+    if (edict)
+    {
+        gEntityIndex->markDirty(edict->getIndex());
+    }
+
+    Luna::pushEdict(L, edict);
+    return 1;
+}
+
+// releaseEntity(edict), parks an acquired entity or removes it once the pool is full
+static int releaseEntity(lua_State *L)
+{
+    auto edict = Luna::toEdict(L, 1);
+
+    lua_pushboolean(L, edict && gEntityPool->release(Luna::getMainThread(L), edict) ==
+                                    Luna::EntityPool::Release::Parked);
+    return 1;
+}
+
+// Returns hits, misses, parked entities and the hit rate of the calling plugin's pool
+static int getEntityPoolStats(lua_State *L)
+{
+    Luna::EntityPool::Stats stats = gEntityPool->getStats(Luna::getMainThread(L));
+    std::uint64_t total = stats.hits + stats.misses;
+
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.hits));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.misses));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.parked));
+    lua_pushnumber(L, total ? static_cast<lua_Number>(stats.hits) / static_cast<lua_Number>(total) : 0.0);
+    return 4;
+}
+
+LuaAdapterCFunction gEntityPoolNatives[] = {
+    {"acquireEntity", acquireEntity},
+    {"releaseEntity", releaseEntity},
+    {"getEntityPoolStats", getEntityPoolStats},
+    {nullptr, nullptr}
+};
@@ -0,0 +1,346 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MessageNatives.hpp"
+#include "EntityHandle.hpp"
+#include "Vec3Natives.hpp"
+
+#include <engine/IEdict.hpp>
+
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+enum class MsgField : std::uint8_t
+{
+    Byte = 0,
+    Char,
+    Short,
+    Long,
+    Entity,
+    Angle,
+    Coord,
+    String
+};
+
+struct MessageField
+{
+    MsgField type;
+    // Index into the params array, 0 for constant fields
+    lua_Integer param;
+    lua_Number number;
+    std::string string;
+};
+
+struct MessageTemplate
+{
+    Anubis::Engine::MsgType msgType;
+    std::vector<MessageField> fields;
+};
+
+// Templates are owned by the plugin that compiled them, keyed by its main thread
+static std::unordered_map<lua_State *, std::unordered_map<lua_Integer, MessageTemplate>> gMessageTemplates;
+static lua_Integer gNextMessageTemplateId = 1;
+
+static void writeField(MsgField type, lua_Number number, std::string_view string)
+{
+    switch (type)
+    {
+        case MsgField::Byte:
+            gEngine->writeByte(static_cast<std::byte>(static_cast<std::uint8_t>(number)), Anubis::FuncCallType::Direct);
+            break;
+        case MsgField::Char:
+            gEngine->writeChar(static_cast<char>(number), Anubis::FuncCallType::Direct);
+            break;
+        case MsgField::Short:
+            gEngine->writeShort(static_cast<std::int16_t>(number), Anubis::FuncCallType::Direct);
+            break;
+        case MsgField::Long:
+            gEngine->writeLong(static_cast<std::int32_t>(number), Anubis::FuncCallType::Direct);
+            break;
+        case MsgField::Entity:
+            gEngine->writeEntity(Anubis::Engine::MsgEntity(static_cast<std::int16_t>(number)),
+                                 Anubis::FuncCallType::Direct);
+            break;
+        case MsgField::Angle:
+            gEngine->writeAngle(Anubis::Engine::MsgAngle(static_cast<float>(number)), Anubis::FuncCallType::Direct);
+            break;
+        case MsgField::Coord:
+            gEngine->writeCoord(Anubis::Engine::MsgCoord(static_cast<float>(number)), Anubis::FuncCallType::Direct);
+            break;
+        case MsgField::String:
+            gEngine->writeString(string, Anubis::FuncCallType::Direct);
+            break;
+    }
+}
+
+// Entity fields take an entity handle or a plain edict index
+static lua_Number toFieldNumber(lua_State *L, int idx, MsgField type)
+{
+    if (type == MsgField::Entity)
+    {
+        if (nstd::observer_ptr<Anubis::Engine::IEdict> edict = Luna::toEdict(L, idx))
+        {
+            return static_cast<lua_Number>(edict->getIndex());
+        }
+    }
+
+    return lua_tonumber(L, idx);
+}
+
+static void sendTemplate(lua_State *L, const MessageTemplate &msgTemplate, int paramsIdx,
+                         Anubis::Engine::MsgDest msgDest, const std::optional<std::array<float, 3>> &origin,
+                         nstd::observer_ptr<Anubis::Engine::IEdict> target)
+{
+    gEngine->messageBegin(msgDest, msgTemplate.msgType, origin, target, Anubis::FuncCallType::Direct);
+
+    for (const MessageField &field : msgTemplate.fields)
+    {
+        if (!field.param)
+        {
+            writeField(field.type, field.number, field.string);
+            continue;
+        }
+
+        lua_rawgeti(L, paramsIdx, field.param);
+
+        if (field.type == MsgField::String)
+        {
+            size_t length = 0;
+            const char *value = lua_tolstring(L, -1, &length);
+            writeField(field.type, 0, value ? std::string_view {value, length} : std::string_view {});
+        }
+        else
+        {
+            writeField(field.type, toFieldNumber(L, -1, field.type), {});
+        }
+
+        lua_pop(L, 1);
+    }
+
+    gEngine->messageEnd(Anubis::FuncCallType::Direct);
+}
+
+static const MessageTemplate &checkTemplate(lua_State *L, int arg)
+{
+    auto &templates = gMessageTemplates[Luna::getMainThread(L)];
+    auto iter = templates.find(luaL_checkinteger(L, arg));
+
+    if (iter == templates.end())
+    {
+        luaL_argerror(L, arg, "invalid message template");
+    }
+
+    return iter->second;
+}
+
+/*
+ * compileMessage(msgType, layout)
+ * Each layout entry is either a field type, which takes the next value from the
+ * params passed when sending, or a {type, value} pair holding a constant.
+ */
+static int compileMessage(lua_State *L)
+{
+    auto msgType = static_cast<std::uint8_t>(luaL_checkinteger(L, 1));
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    MessageTemplate msgTemplate {Anubis::Engine::MsgType(msgType), {}};
+    lua_Integer params = 0;
+
+    auto length = static_cast<lua_Integer>(lua_rawlen(L, 2));
+    msgTemplate.fields.reserve(static_cast<std::size_t>(length));
+
+    for (lua_Integer i = 1; i <= length; i++)
+    {
+        MessageField field {};
+
+        if (lua_rawgeti(L, 2, i) == LUA_TTABLE)
+        {
+            lua_rawgeti(L, -1, 1);
+            field.type = static_cast<MsgField>(lua_tointeger(L, -1));
+            lua_rawgeti(L, -2, 2);
+
+            if (field.type == MsgField::String)
+            {
+                size_t strLength = 0;
+                const char *value = lua_tolstring(L, -1, &strLength);
+                field.string.assign(value ? value : "", value ? strLength : 0);
+            }
+            else
+            {
+                field.number = toFieldNumber(L, -1, field.type);
+            }
+
+            lua_pop(L, 2);
+        }
+        else
+        {
+            field.type = static_cast<MsgField>(lua_tointeger(L, -1));
+            field.param = ++params;
+        }
+
+        lua_pop(L, 1);
+
+        if (field.type > MsgField::String)
+        {
+            return luaL_error(L, "invalid field type at layout position %d", static_cast<int>(i));
+        }
+
+        msgTemplate.fields.emplace_back(std::move(field));
+    }
+
+    lua_Integer id = gNextMessageTemplateId++;
+    gMessageTemplates[Luna::getMainThread(L)].emplace(id, std::move(msgTemplate));
+
+    lua_pushinteger(L, id);
+    return 1;
+}
+
+static int destroyMessage(lua_State *L)
+{
+    if (auto iter = gMessageTemplates.find(Luna::getMainThread(L)); iter != gMessageTemplates.end())
+    {
+        iter->second.erase(luaL_checkinteger(L, 1));
+    }
+
+    return 0;
+}
+
+// sendMessage(template, dest, target, params [, origin])
+static int sendMessage(lua_State *L)
+{
+    const MessageTemplate &msgTemplate = checkTemplate(L, 1);
+    auto msgDest = static_cast<Anubis::Engine::MsgDest>(luaL_checkinteger(L, 2));
+    nstd::observer_ptr<Anubis::Engine::IEdict> target = Luna::toEdict(L, 3);
+    luaL_checktype(L, 4, LUA_TTABLE);
+
+    if (!target &&
+        (msgDest == Anubis::Engine::MsgDest::One || msgDest == Anubis::Engine::MsgDest::OneUnreliable))
+    {
+        return luaL_argerror(L, 3, "message destination requires a valid target");
+    }
+
+    std::optional<std::array<float, 3>> origin;
+    if (!lua_isnoneornil(L, 5))
+    {
+        origin.emplace();
+        Luna::getVec3Args(L, 5, *origin);
+    }
+
+    sendTemplate(L, msgTemplate, 4, msgDest, origin, target);
+    return 0;
+}
+
+/*
+ * sendMessageToPlayers(template, dest, players, params)
+ * players is an array of entity handles, nil sends to every connected player.
+ * params is either one params array shared by all targets or an array of
+ * params arrays, one per target.
+ */
+static int sendMessageToPlayers(lua_State *L)
+{
+    using Anubis::Engine::IEdict;
+
+    const MessageTemplate &msgTemplate = checkTemplate(L, 1);
+    auto msgDest = static_cast<Anubis::Engine::MsgDest>(luaL_checkinteger(L, 2));
+    luaL_checktype(L, 4, LUA_TTABLE);
+
+    // Per-target params may be sparse when keyed by edict index, so look at the first present entry
+    bool perTarget = false;
+
+    lua_pushnil(L);
+    if (lua_next(L, 4))
+    {
+        perTarget = lua_type(L, -1) == LUA_TTABLE;
+        lua_pop(L, 2);
+    }
+
+    lua_Integer sent = 0;
+
+    auto sendTo = [&](nstd::observer_ptr<IEdict> edict, lua_Integer slot)
+    {
+        if (!perTarget)
+        {
+            sendTemplate(L, msgTemplate, 4, msgDest, std::nullopt, edict);
+            sent++;
+            return;
+        }
+
+        if (lua_rawgeti(L, 4, slot) == LUA_TTABLE)
+        {
+            sendTemplate(L, msgTemplate, lua_gettop(L), msgDest, std::nullopt, edict);
+            sent++;
+        }
+
+        lua_pop(L, 1);
+    };
+
+    if (lua_isnoneornil(L, 3))
+    {
+        std::uint32_t maxClients = gEngine->getMaxClients();
+
+        for (std::uint32_t i = 1; i <= maxClients; i++)
+        {
+            nstd::observer_ptr<IEdict> edict = gEngine->getEdict(i, Anubis::FuncCallType::Direct);
+
+            if (!edict || edict->isFree() ||
+                !(static_cast<std::uint32_t>(edict->getFlags()) & static_cast<std::uint32_t>(IEdict::Flag::Client)))
+            {
+                continue;
+            }
+
+            // Per-target params are indexed by edict index when sending to everyone
+            sendTo(edict, static_cast<lua_Integer>(i));
+        }
+    }
+    else
+    {
+        luaL_checktype(L, 3, LUA_TTABLE);
+        auto count = static_cast<lua_Integer>(lua_rawlen(L, 3));
+
+        for (lua_Integer i = 1; i <= count; i++)
+        {
+            lua_rawgeti(L, 3, i);
+            nstd::observer_ptr<IEdict> edict = Luna::toEdict(L, -1);
+            lua_pop(L, 1);
+
+            if (edict)
+            {
+                sendTo(edict, i);
+            }
+        }
+    }
+
+    lua_pushinteger(L, sent);
+    return 1;
+}
+
+void dropMessageTemplates(lua_State *L)
+{
+    gMessageTemplates.erase(L);
+}
+
+LuaAdapterCFunction gMessageNatives[] = {
+    {"compileMessage", compileMessage},
+    {"destroyMessage", destroyMessage},
+    {"sendMessage", sendMessage},
+    {"sendMessageToPlayers", sendMessageToPlayers},
+    {nullptr, nullptr}
+};
@@ -22,6 +22,22 @@
 #include "BasicNatives.hpp"
 #include "EdictNatives.hpp"
 #include "ClassNatives.hpp"
+#include "SnapshotNatives.hpp"
+#include "SpatialNatives.hpp"
+#include "EntityIndexNatives.hpp"
+#include "Vec3Natives.hpp"
+#include "TraceNatives.hpp"
+#include "MessageNatives.hpp"
+#include "WatchNatives.hpp"
+#include "WatchSystem.hpp"
+#include "EntityPoolNatives.hpp"
+#include "EntityPool.hpp"
+#include "TweenNatives.hpp"
+#include "TweenSystem.hpp"
+#include "EntVarsNatives.hpp"
+#include "sql/AsyncDispatcher.hpp"
+#include "sql/WriteBehind.hpp"
+#include "sql/Handles.hpp"
 #include "sql/Natives.hpp"
 
 #include <fmt/format.h>
@@ -34,29 +50,20 @@ namespace Luna
         : m_pluginInfo(std::move(pluginInfo)), m_luaState(luaState), m_id(pid)
     {
             luaL_openlibs(m_luaState.get());
-            std::size_t i = 0;
-            do
-            {
-                lua_register(m_luaState.get(), gBasicNatives[i].name, gBasicNatives[i].func);
-            } while (gBasicNatives[++i].func);
-
-            i = 0;
-            do
-            {
-                lua_register(m_luaState.get(), gEdictNatives[i].name, gEdictNatives[i].func);
-            } while (gEdictNatives[++i].func);
-
-            i = 0;
-            do
-            {
-                lua_register(m_luaState.get(), gClassNatives[i].name, gClassNatives[i].func);
-            } while (gClassNatives[++i].func);
-
-            i = 0;
-            do
-            {
-                lua_register(m_luaState.get(), gSQLNatives[i].name, gSQLNatives[i].func);
-            } while (gSQLNatives[++i].func);
+            _registerNatives(gBasicNatives);
+            _registerNatives(gEdictNatives);
+            _registerNatives(gClassNatives);
+            _registerNatives(gSQLNatives);
+            _registerNatives(gSnapshotNatives);
+            _registerNatives(gSpatialNatives);
+            _registerNatives(gEntityIndexNatives);
+            _registerNatives(gVec3Natives);
+            _registerNatives(gTraceNatives);
+            _registerNatives(gMessageNatives);
+            _registerNatives(gWatchNatives);
+            _registerNatives(gEntityPoolNatives);
+            _registerNatives(gTweenNatives);
+            _registerNatives(gEntVarsNatives);
 
             if (lua_getglobal(m_luaState.get(), "maxClients") != LUA_TNIL)
             {
@@ -78,9 +85,24 @@ namespace Luna
 
     Plugin::~Plugin()
     {
+        gPropertyWatcher->unwatchAll(m_luaState.get());
+        gEntityPool->drop(m_luaState.get());
+        gTweenSystem->cancelAll(m_luaState.get());
+        dropMessageTemplates(m_luaState.get());
+        gSQLWriteBehind->drop(m_luaState.get());
+        gSQLDispatcher->cancel(m_luaState.get());
+        gSQLHandles->drop(m_luaState.get(), m_pluginInfo.name);
         lua_close(m_luaState.get());
     }
 
+    void Plugin::_registerNatives(const LuaAdapterCFunction *natives)
+    {
+        for (std::size_t i = 0; natives[i].func; i++)
+        {
+            lua_register(m_luaState.get(), natives[i].name, natives[i].func);
+        }
+    }
+
     void Plugin::allowVFuncHooks() const
     {
         if (lua_getglobal(m_luaState.get(), "__installVFuncHooks") != LUA_TNIL)
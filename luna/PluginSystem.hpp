@@ -30,6 +30,8 @@
 
 #include <observer_ptr.hpp>
 
+#include "CommonNatives.hpp"
+
 namespace Luna
 {
     struct PluginInfo
@@ -58,6 +60,9 @@ namespace Luna
         void allowVFuncHooks() const;
         auto getState() const { return m_luaState; }
 
+    private:
+        void _registerNatives(const LuaAdapterCFunction *natives);
+
     private:
         PluginInfo m_pluginInfo{};
         nstd::observer_ptr<lua_State> m_luaState{};
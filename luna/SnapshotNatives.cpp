@@ -0,0 +1,102 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SnapshotNatives.hpp"
+#include "SnapshotSystem.hpp"
+
+static constexpr const char *SNAPSHOT_ARRAY_MT = "LunaSnapshotArray";
+
+struct SnapshotArray
+{
+    Luna::PlayerSnapshot::Column column;
+};
+
+static int snapshotArrayIndex(lua_State *L)
+{
+    auto array = reinterpret_cast<SnapshotArray *>(luaL_checkudata(L, 1, SNAPSHOT_ARRAY_MT));
+    lua_Integer index = lua_tointeger(L, 2);
+
+    if (index < 1 || index > static_cast<lua_Integer>(gPlayerSnapshot->getMaxClients()))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (gPlayerSnapshot->isFloatColumn(array->column))
+    {
+        lua_pushnumber(L, gPlayerSnapshot->getFloatColumn(array->column)[index]);
+    }
+    else
+    {
+        lua_pushinteger(L, gPlayerSnapshot->getIntColumn(array->column)[index]);
+    }
+
+    return 1;
+}
+
+static int snapshotArrayNewIndex(lua_State *L)
+{
+    return luaL_error(L, "player snapshot is read-only");
+}
+
+static int snapshotArrayLen(lua_State *L)
+{
+    lua_pushinteger(L, static_cast<lua_Integer>(gPlayerSnapshot->getMaxClients()));
+    return 1;
+}
+
+static int getPlayerSnapshot(lua_State *L)
+{
+    lua_Integer index = luaL_checkinteger(L, 1);
+
+    if (index < 0 || index > static_cast<lua_Integer>(Luna::PlayerSnapshot::Column::Connected))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    auto column = static_cast<Luna::PlayerSnapshot::Column>(index);
+
+    if (!gPlayerSnapshot->isCaptured(column))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    auto array = reinterpret_cast<SnapshotArray *>(lua_newuserdatauv(L, sizeof(SnapshotArray), 0));
+    array->column = column;
+
+    if (luaL_newmetatable(L, SNAPSHOT_ARRAY_MT))
+    {
+        lua_pushcfunction(L, snapshotArrayIndex);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, snapshotArrayNewIndex);
+        lua_setfield(L, -2, "__newindex");
+        lua_pushcfunction(L, snapshotArrayLen);
+        lua_setfield(L, -2, "__len");
+    }
+
+    lua_setmetatable(L, -2);
+    return 1;
+}
+
+LuaAdapterCFunction gSnapshotNatives[] = {
+    {"getPlayerSnapshot", getPlayerSnapshot},
+    {nullptr, nullptr}
+};
@@ -0,0 +1,210 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SnapshotSystem.hpp"
+#include "AnubisExports.hpp"
+
+#include <engine/IEdict.hpp>
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+    constexpr std::size_t toIndex(Luna::PlayerSnapshot::Column column)
+    {
+        return static_cast<std::size_t>(column);
+    }
+
+    constexpr std::size_t toIntIndex(Luna::PlayerSnapshot::Column column)
+    {
+        return static_cast<std::size_t>(column) - Luna::PlayerSnapshot::FLOAT_COLUMNS;
+    }
+}
+
+namespace Luna
+{
+    PlayerSnapshot::PlayerSnapshot(const std::vector<std::string> &properties)
+    {
+        for (std::string name : properties)
+        {
+            std::transform(name.begin(), name.end(), name.begin(),
+                           [](unsigned char c)
+                           {
+                               return std::tolower(c);
+                           });
+
+            if (name == "origin")
+            {
+                _enable(Property::Origin);
+            }
+            else if (name == "velocity")
+            {
+                _enable(Property::Velocity);
+            }
+            else if (name == "angles")
+            {
+                _enable(Property::Angles);
+            }
+            else if (name == "flags")
+            {
+                _enable(Property::Flags);
+            }
+            else if (name == "health")
+            {
+                _enable(Property::Health);
+            }
+            else if (name == "team")
+            {
+                _enable(Property::Team);
+            }
+        }
+    }
+
+    void PlayerSnapshot::_enable(Property property)
+    {
+        m_enabled[static_cast<std::size_t>(property)] = true;
+    }
+
+    void PlayerSnapshot::capture()
+    {
+        using Anubis::Engine::IEdict;
+
+        m_maxClients = std::min<std::uint32_t>(gEngine->getMaxClients(), MAX_SLOTS - 1);
+
+        const bool origin = m_enabled[static_cast<std::size_t>(Property::Origin)];
+        const bool velocity = m_enabled[static_cast<std::size_t>(Property::Velocity)];
+        const bool angles = m_enabled[static_cast<std::size_t>(Property::Angles)];
+        const bool flags = m_enabled[static_cast<std::size_t>(Property::Flags)];
+        const bool health = m_enabled[static_cast<std::size_t>(Property::Health)];
+        const bool team = m_enabled[static_cast<std::size_t>(Property::Team)];
+
+        auto &connected = m_ints[toIntIndex(Column::Connected)];
+
+        for (std::uint32_t i = 1; i <= m_maxClients; i++)
+        {
+            nstd::observer_ptr<IEdict> edict = gEngine->getEdict(i, Anubis::FuncCallType::Direct);
+
+            if (!edict || edict->isFree())
+            {
+                connected[i] = 0;
+                continue;
+            }
+
+            auto edictFlags = static_cast<std::uint32_t>(edict->getFlags());
+            if (!(edictFlags & static_cast<std::uint32_t>(IEdict::Flag::Client)))
+            {
+                connected[i] = 0;
+                continue;
+            }
+
+            connected[i] = 1;
+
+            if (origin)
+            {
+                std::array<float, 3> value = edict->getVecProperty(IEdict::VecProperty::Origin);
+                m_floats[toIndex(Column::OriginX)][i] = value[0];
+                m_floats[toIndex(Column::OriginY)][i] = value[1];
+                m_floats[toIndex(Column::OriginZ)][i] = value[2];
+            }
+
+            if (velocity)
+            {
+                std::array<float, 3> value = edict->getVecProperty(IEdict::VecProperty::Velocity);
+                m_floats[toIndex(Column::VelocityX)][i] = value[0];
+                m_floats[toIndex(Column::VelocityY)][i] = value[1];
+                m_floats[toIndex(Column::VelocityZ)][i] = value[2];
+            }
+
+            if (angles)
+            {
+                std::array<float, 3> value = edict->getVecProperty(IEdict::VecProperty::Angles);
+                m_floats[toIndex(Column::AnglesX)][i] = value[0];
+                m_floats[toIndex(Column::AnglesY)][i] = value[1];
+                m_floats[toIndex(Column::AnglesZ)][i] = value[2];
+            }
+
+            if (health)
+            {
+                m_floats[toIndex(Column::Health)][i] = edict->getFlProperty(IEdict::FlProperty::Health);
+            }
+
+            if (flags)
+            {
+                m_ints[toIntIndex(Column::Flags)][i] = static_cast<std::int32_t>(edictFlags);
+            }
+
+            if (team)
+            {
+                m_ints[toIntIndex(Column::Team)][i] = edict->getIntProperty(IEdict::IntProperty::Team);
+            }
+        }
+    }
+
+    bool PlayerSnapshot::isCaptured(Column column) const
+    {
+        switch (column)
+        {
+            case Column::OriginX:
+            case Column::OriginY:
+            case Column::OriginZ:
+                return m_enabled[static_cast<std::size_t>(Property::Origin)];
+            case Column::VelocityX:
+            case Column::VelocityY:
+            case Column::VelocityZ:
+                return m_enabled[static_cast<std::size_t>(Property::Velocity)];
+            case Column::AnglesX:
+            case Column::AnglesY:
+            case Column::AnglesZ:
+                return m_enabled[static_cast<std::size_t>(Property::Angles)];
+            case Column::Health:
+                return m_enabled[static_cast<std::size_t>(Property::Health)];
+            case Column::Flags:
+                return m_enabled[static_cast<std::size_t>(Property::Flags)];
+            case Column::Team:
+                return m_enabled[static_cast<std::size_t>(Property::Team)];
+            case Column::Connected:
+                return true;
+        }
+
+        return false;
+    }
+
+    bool PlayerSnapshot::isFloatColumn(Column column) const
+    {
+        return toIndex(column) < FLOAT_COLUMNS;
+    }
+
+    const float *PlayerSnapshot::getFloatColumn(Column column) const
+    {
+        return m_floats[toIndex(column)].data();
+    }
+
+    const std::int32_t *PlayerSnapshot::getIntColumn(Column column) const
+    {
+        return m_ints[toIntIndex(column)].data();
+    }
+
+    std::uint32_t PlayerSnapshot::getMaxClients() const
+    {
+        return m_maxClients;
+    }
+}
+
+std::unique_ptr<Luna::PlayerSnapshot> gPlayerSnapshot;
@@ -0,0 +1,93 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Luna
+{
+    /**
+     * @brief Per-frame structure-of-arrays copy of player properties.
+     *
+     * Captured once in ServerFrame so plugins can read player state without
+     * going through IEdict virtuals. Every column is indexed by edict index.
+     */
+    class PlayerSnapshot
+    {
+    public:
+        static constexpr std::size_t MAX_SLOTS = 33;
+
+        enum class Property : std::uint8_t
+        {
+            Origin = 0,
+            Velocity,
+            Angles,
+            Flags,
+            Health,
+            Team
+        };
+
+        enum class Column : std::uint8_t
+        {
+            OriginX = 0,
+            OriginY,
+            OriginZ,
+            VelocityX,
+            VelocityY,
+            VelocityZ,
+            AnglesX,
+            AnglesY,
+            AnglesZ,
+            Health,
+            Flags,
+            Team,
+            Connected
+        };
+
+        static constexpr std::size_t FLOAT_COLUMNS = static_cast<std::size_t>(Column::Health) + 1;
+        static constexpr std::size_t INT_COLUMNS = static_cast<std::size_t>(Column::Connected) - FLOAT_COLUMNS + 1;
+
+    public:
+        explicit PlayerSnapshot(const std::vector<std::string> &properties);
+
+        void capture();
+
+        [[nodiscard]] bool isCaptured(Column column) const;
+        [[nodiscard]] bool isFloatColumn(Column column) const;
+        [[nodiscard]] const float *getFloatColumn(Column column) const;
+        [[nodiscard]] const std::int32_t *getIntColumn(Column column) const;
+        [[nodiscard]] std::uint32_t getMaxClients() const;
+
+    private:
+        void _enable(Property property);
+
+    private:
+        std::array<bool, static_cast<std::size_t>(Property::Team) + 1> m_enabled{};
+        std::uint32_t m_maxClients{};
+        alignas(16) std::array<std::array<float, MAX_SLOTS>, FLOAT_COLUMNS> m_floats{};
+        alignas(16) std::array<std::array<std::int32_t, MAX_SLOTS>, INT_COLUMNS> m_ints{};
+    };
+}
+
+extern std::unique_ptr<Luna::PlayerSnapshot> gPlayerSnapshot;
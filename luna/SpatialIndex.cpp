@@ -0,0 +1,387 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SpatialIndex.hpp"
+#include "AnubisExports.hpp"
+
+#include <engine/IEdict.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Luna
+{
+    SpatialIndex::SpatialIndex()
+    {
+        m_mobile.reserve(MAX_EDICTS);
+        m_dirty.reserve(MAX_EDICTS);
+        m_stale.reserve(MAX_EDICTS);
+    }
+
+    std::int32_t SpatialIndex::_toCellCoord(float value)
+    {
+        float coord = std::floor((value - WORLD_MIN) / CELL_SIZE);
+
+        // Clamped before the cast, converting NaN or an out of range float is undefined
+        if (!(coord > 0.0f))
+        {
+            return 0;
+        }
+
+        return static_cast<std::int32_t>(std::min(coord, static_cast<float>(GRID_SIZE - 1)));
+    }
+
+    std::int32_t SpatialIndex::_toCell(const std::array<float, 3> &origin)
+    {
+        return _toCellCoord(origin[1]) * GRID_SIZE + _toCellCoord(origin[0]);
+    }
+
+    float SpatialIndex::_distanceSq(const std::array<float, 3> &a, const std::array<float, 3> &b)
+    {
+        float x = a[0] - b[0];
+        float y = a[1] - b[1];
+        float z = a[2] - b[2];
+
+        return x * x + y * y + z * z;
+    }
+
+    void SpatialIndex::rebuild(std::uint32_t edictCount)
+    {
+        clear();
+
+        for (std::uint32_t i = 1; i < std::min(edictCount, MAX_EDICTS); i++)
+        {
+            nstd::observer_ptr<Anubis::Engine::IEdict> edict = gEngine->getEdict(i, Anubis::FuncCallType::Direct);
+
+            if (!edict || edict->isFree())
+            {
+                continue;
+            }
+
+            _refresh(i);
+        }
+    }
+
+    void SpatialIndex::clear()
+    {
+        for (auto &cell : m_cells)
+        {
+            cell.clear();
+        }
+
+        m_entries.fill({});
+        m_mobile.clear();
+        m_dirty.clear();
+    }
+
+    void SpatialIndex::update()
+    {
+        for (std::uint16_t index : m_dirty)
+        {
+            // Removed after it was marked
+            if (!m_entries[index].dirty)
+            {
+                continue;
+            }
+
+            m_entries[index].dirty = false;
+            _refresh(index);
+        }
+
+        m_dirty.clear();
+
+        // Walk backwards, _refresh() may swap-remove the current element
+        for (std::size_t i = m_mobile.size(); i-- > 0;)
+        {
+            _refresh(m_mobile[i]);
+        }
+    }
+
+    void SpatialIndex::markDirty(std::uint32_t index)
+    {
+        if (!index || index >= MAX_EDICTS)
+        {
+            return;
+        }
+
+        Entry &entry = m_entries[index];
+        if (!entry.dirty)
+        {
+            entry.dirty = true;
+            m_dirty.push_back(static_cast<std::uint16_t>(index));
+        }
+    }
+
+    void SpatialIndex::remove(std::uint32_t index)
+    {
+        if (!index || index >= MAX_EDICTS)
+        {
+            return;
+        }
+
+        _unlink(index);
+        _setMobile(index, false);
+        m_entries[index].dirty = false;
+    }
+
+    void SpatialIndex::_refresh(std::uint32_t index)
+    {
+        using Anubis::Engine::IEdict;
+
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(index, Anubis::FuncCallType::Direct);
+
+        if (!edict || edict->isFree())
+        {
+            remove(index);
+            return;
+        }
+
+        Entry &entry = m_entries[index];
+        entry.origin = edict->getVecProperty(IEdict::VecProperty::Origin);
+        entry.serialNumber = edict->getSerialNumber();
+
+        std::int32_t cell = _toCell(entry.origin);
+        if (cell != entry.cell)
+        {
+            _unlink(index);
+            _link(index, cell);
+        }
+
+        _setMobile(index, edict->getMoveType() != IEdict::MoveType::None);
+    }
+
+    void SpatialIndex::_link(std::uint32_t index, std::int32_t cell)
+    {
+        auto &bucket = m_cells[static_cast<std::size_t>(cell)];
+
+        Entry &entry = m_entries[index];
+        entry.cell = cell;
+        entry.slot = static_cast<std::uint32_t>(bucket.size());
+
+        bucket.push_back(static_cast<std::uint16_t>(index));
+    }
+
+    void SpatialIndex::_unlink(std::uint32_t index)
+    {
+        Entry &entry = m_entries[index];
+        if (entry.cell < 0)
+        {
+            return;
+        }
+
+        auto &bucket = m_cells[static_cast<std::size_t>(entry.cell)];
+        std::uint16_t last = bucket.back();
+
+        bucket[entry.slot] = last;
+        m_entries[last].slot = entry.slot;
+        bucket.pop_back();
+
+        entry.cell = -1;
+    }
+
+    void SpatialIndex::_setMobile(std::uint32_t index, bool mobile)
+    {
+        Entry &entry = m_entries[index];
+        if (entry.mobile == mobile)
+        {
+            return;
+        }
+
+        entry.mobile = mobile;
+
+        if (mobile)
+        {
+            entry.mobileSlot = static_cast<std::uint32_t>(m_mobile.size());
+            m_mobile.push_back(static_cast<std::uint16_t>(index));
+            return;
+        }
+
+        std::uint16_t last = m_mobile.back();
+
+        m_mobile[entry.mobileSlot] = last;
+        m_entries[last].mobileSlot = entry.mobileSlot;
+        m_mobile.pop_back();
+    }
+
+    bool SpatialIndex::_matches(std::uint32_t index, const Filter &filter)
+    {
+        using Anubis::Engine::IEdict;
+
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(index, Anubis::FuncCallType::Direct);
+
+        // Freed or reused slot, the bucket is being walked so it is removed after the query
+        if (!edict || edict->isFree() || edict->getSerialNumber() != m_entries[index].serialNumber)
+        {
+            m_stale.push_back(static_cast<std::uint16_t>(index));
+            return false;
+        }
+
+        if (filter.flags && (static_cast<std::uint32_t>(edict->getFlags()) & filter.flags) != filter.flags)
+        {
+            return false;
+        }
+
+        if (!filter.className.empty())
+        {
+            std::string_view className = gEngine->getString(edict->getStrProperty(IEdict::StrProperty::ClassName),
+                                                            Anubis::FuncCallType::Direct);
+
+            return className == filter.className;
+        }
+
+        return true;
+    }
+
+    void SpatialIndex::_removeStale()
+    {
+        for (std::uint16_t index : m_stale)
+        {
+            remove(index);
+        }
+
+        m_stale.clear();
+    }
+
+    template<typename t_pred>
+    void SpatialIndex::_collect(std::int32_t minX, std::int32_t minY, std::int32_t maxX, std::int32_t maxY,
+                                t_pred &&pred)
+    {
+        for (std::int32_t y = minY; y <= maxY; y++)
+        {
+            for (std::int32_t x = minX; x <= maxX; x++)
+            {
+                for (std::uint16_t index : m_cells[static_cast<std::size_t>(y * GRID_SIZE + x)])
+                {
+                    pred(index);
+                }
+            }
+        }
+    }
+
+    std::size_t SpatialIndex::findInSphere(const std::array<float, 3> &origin, float radius, const Filter &filter,
+                                           std::vector<std::uint32_t> &results)
+    {
+        results.clear();
+
+        const float radiusSq = radius * radius;
+
+        _collect(_toCellCoord(origin[0] - radius), _toCellCoord(origin[1] - radius),
+                 _toCellCoord(origin[0] + radius), _toCellCoord(origin[1] + radius),
+                 [&](std::uint32_t index)
+                 {
+                     if (_distanceSq(m_entries[index].origin, origin) <= radiusSq && _matches(index, filter))
+                     {
+                         results.push_back(index);
+                     }
+                 });
+
+        _removeStale();
+
+        return results.size();
+    }
+
+    std::size_t SpatialIndex::findInBox(const std::array<float, 3> &mins, const std::array<float, 3> &maxs,
+                                        const Filter &filter, std::vector<std::uint32_t> &results)
+    {
+        results.clear();
+
+        _collect(_toCellCoord(mins[0]), _toCellCoord(mins[1]), _toCellCoord(maxs[0]), _toCellCoord(maxs[1]),
+                 [&](std::uint32_t index)
+                 {
+                     const auto &pos = m_entries[index].origin;
+
+                     if (pos[0] < mins[0] || pos[1] < mins[1] || pos[2] < mins[2] ||
+                         pos[0] > maxs[0] || pos[1] > maxs[1] || pos[2] > maxs[2])
+                     {
+                         return;
+                     }
+
+                     if (_matches(index, filter))
+                     {
+                         results.push_back(index);
+                     }
+                 });
+
+        _removeStale();
+
+        return results.size();
+    }
+
+    std::size_t SpatialIndex::nearest(const std::array<float, 3> &origin, std::size_t count, float maxRadius,
+                                      const Filter &filter, std::vector<std::uint32_t> &results)
+    {
+        results.clear();
+        m_nearest.clear();
+
+        if (!count)
+        {
+            return 0;
+        }
+
+        std::int32_t minX = 0;
+        std::int32_t minY = 0;
+        std::int32_t maxX = GRID_SIZE - 1;
+        std::int32_t maxY = GRID_SIZE - 1;
+
+        if (maxRadius > 0.0f)
+        {
+            minX = _toCellCoord(origin[0] - maxRadius);
+            minY = _toCellCoord(origin[1] - maxRadius);
+            maxX = _toCellCoord(origin[0] + maxRadius);
+            maxY = _toCellCoord(origin[1] + maxRadius);
+        }
+
+        const float radiusSq = maxRadius * maxRadius;
+
+        _collect(minX, minY, maxX, maxY,
+                 [&](std::uint32_t index)
+                 {
+                     float distance = _distanceSq(m_entries[index].origin, origin);
+
+                     if (maxRadius <= 0.0f || distance <= radiusSq)
+                     {
+                         m_nearest.emplace_back(distance, index);
+                     }
+                 });
+
+        // Filters need engine calls so test candidates in distance order and stop once enough were found
+        std::sort(m_nearest.begin(), m_nearest.end());
+
+        for (const auto &[distance, index] : m_nearest)
+        {
+            if (!_matches(index, filter))
+            {
+                continue;
+            }
+
+            results.push_back(index);
+
+            if (results.size() == count)
+            {
+                break;
+            }
+        }
+
+        _removeStale();
+
+        return results.size();
+    }
+}
+
+std::unique_ptr<Luna::SpatialIndex> gSpatialIndex;
@@ -0,0 +1,106 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Luna
+{
+    /**
+     * @brief Uniform 2D grid over entity origins.
+     *
+     * Entities are bucketed by their X/Y origin. Height is checked against the
+     * cached origin during queries. Static entities are only relinked when they
+     * are marked dirty (setOrigin), moving entities are refreshed every frame.
+     */
+    class SpatialIndex
+    {
+    public:
+        static constexpr std::uint32_t MAX_EDICTS = 2048;
+        static constexpr float CELL_SIZE = 256.0f;
+        static constexpr float WORLD_MIN = -4096.0f;
+        static constexpr std::int32_t GRID_SIZE = 32;
+
+        struct Filter
+        {
+            std::string_view className;
+            std::uint32_t flags;
+        };
+
+    public:
+        SpatialIndex();
+
+        // edictCount is the count passed to ServerActivate
+        void rebuild(std::uint32_t edictCount);
+        void clear();
+        void update();
+        void markDirty(std::uint32_t index);
+        void remove(std::uint32_t index);
+
+        std::size_t findInSphere(const std::array<float, 3> &origin, float radius, const Filter &filter,
+                                 std::vector<std::uint32_t> &results);
+        std::size_t findInBox(const std::array<float, 3> &mins, const std::array<float, 3> &maxs,
+                              const Filter &filter, std::vector<std::uint32_t> &results);
+        std::size_t nearest(const std::array<float, 3> &origin, std::size_t count, float maxRadius,
+                            const Filter &filter, std::vector<std::uint32_t> &results);
+
+    private:
+        struct Entry
+        {
+            std::array<float, 3> origin;
+            std::uint32_t serialNumber = 0;
+            std::int32_t cell = -1;
+            std::uint32_t slot = 0;
+            std::uint32_t mobileSlot = 0;
+            bool mobile = false;
+            bool dirty = false;
+        };
+
+    private:
+        static std::int32_t _toCellCoord(float value);
+        static std::int32_t _toCell(const std::array<float, 3> &origin);
+        static float _distanceSq(const std::array<float, 3> &a, const std::array<float, 3> &b);
+
+        void _refresh(std::uint32_t index);
+        void _link(std::uint32_t index, std::int32_t cell);
+        void _unlink(std::uint32_t index);
+        void _setMobile(std::uint32_t index, bool mobile);
+        // Entities freed without going through RemoveEntity are queued for removal
+        [[nodiscard]] bool _matches(std::uint32_t index, const Filter &filter);
+        void _removeStale();
+
+        template<typename t_pred>
+        void _collect(std::int32_t minX, std::int32_t minY, std::int32_t maxX, std::int32_t maxY, t_pred &&pred);
+
+    private:
+        std::array<Entry, MAX_EDICTS> m_entries{};
+        std::array<std::vector<std::uint16_t>, GRID_SIZE * GRID_SIZE> m_cells{};
+        std::vector<std::uint16_t> m_mobile;
+        std::vector<std::uint16_t> m_dirty;
+        std::vector<std::uint16_t> m_stale;
+        std::vector<std::pair<float, std::uint32_t>> m_nearest;
+    };
+}
+
+extern std::unique_ptr<Luna::SpatialIndex> gSpatialIndex;
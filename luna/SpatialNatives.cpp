@@ -0,0 +1,123 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "SpatialNatives.hpp"
+#include "SpatialIndex.hpp"
+#include "AnubisExports.hpp"
+#include "EntityHandle.hpp"
+#include "Vec3Natives.hpp"
+
+#include <engine/IEdict.hpp>
+
+#include <vector>
+
+static std::vector<std::uint32_t> gSpatialResults;
+
+static Luna::SpatialIndex::Filter getFilter(lua_State *L, int classNameArg, int flagsArg)
+{
+    Luna::SpatialIndex::Filter filter {};
+
+    if (!lua_isnoneornil(L, classNameArg))
+    {
+        size_t length;
+        const char *className = luaL_checklstring(L, classNameArg, &length);
+        filter.className = {className, length};
+    }
+
+    filter.flags = static_cast<std::uint32_t>(luaL_optinteger(L, flagsArg, 0));
+
+    return filter;
+}
+
+// Fills the table passed at tableArg (or a new one) with the results, stale entries past the end are cleared
+static int pushResults(lua_State *L, int tableArg)
+{
+    lua_Integer oldLength = 0;
+
+    if (lua_istable(L, tableArg))
+    {
+        lua_pushvalue(L, tableArg);
+        oldLength = static_cast<lua_Integer>(lua_rawlen(L, -1));
+    }
+    else
+    {
+        lua_createtable(L, static_cast<int>(gSpatialResults.size()), 0);
+    }
+
+    lua_Integer i = 1;
+    for (std::uint32_t index : gSpatialResults)
+    {
+        Luna::pushEdict(L, gEngine->getEdict(index, Anubis::FuncCallType::Direct));
+        lua_rawseti(L, -2, i++);
+    }
+
+    for (; i <= oldLength; i++)
+    {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+
+    lua_pushinteger(L, static_cast<lua_Integer>(gSpatialResults.size()));
+
+    return 2;
+}
+
+static int findInSphere(lua_State *L)
+{
+    std::array<float, 3> origin {};
+    int arg = Luna::getVec3Args(L, 1, origin);
+
+    auto radius = static_cast<float>(luaL_checknumber(L, arg));
+
+    gSpatialIndex->findInSphere(origin, radius, getFilter(L, arg + 1, arg + 2), gSpatialResults);
+
+    return pushResults(L, arg + 3);
+}
+
+static int findInBox(lua_State *L)
+{
+    std::array<float, 3> mins {};
+    std::array<float, 3> maxs {};
+    int arg = Luna::getVec3Args(L, Luna::getVec3Args(L, 1, mins), maxs);
+
+    gSpatialIndex->findInBox(mins, maxs, getFilter(L, arg, arg + 1), gSpatialResults);
+
+    return pushResults(L, arg + 2);
+}
+
+static int nearestN(lua_State *L)
+{
+    std::array<float, 3> origin {};
+    int arg = Luna::getVec3Args(L, 1, origin);
+
+    lua_Integer count = luaL_checkinteger(L, arg);
+    auto maxRadius = static_cast<float>(luaL_optnumber(L, arg + 1, 0.0));
+
+    gSpatialIndex->nearest(origin, count > 0 ? static_cast<std::size_t>(count) : 0, maxRadius,
+                           getFilter(L, arg + 2, arg + 3), gSpatialResults);
+
+    return pushResults(L, arg + 4);
+}
+
+LuaAdapterCFunction gSpatialNatives[] = {
+    {"findInSphere", findInSphere},
+    {"findInBox", findInBox},
+    {"nearestN", nearestN},
+    {nullptr, nullptr}
+};
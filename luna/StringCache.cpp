@@ -0,0 +1,63 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "StringCache.hpp"
+#include "AnubisExports.hpp"
+
+namespace Luna
+{
+    Anubis::Engine::StringOffset StringCache::alloc(std::string_view value)
+    {
+        if (auto it = m_strings.find(value); it != m_strings.end())
+        {
+            m_hits++;
+            return it->second;
+        }
+
+        m_misses++;
+
+        Anubis::Engine::StringOffset offset = gEngine->allocString(value, Anubis::FuncCallType::Direct);
+        m_strings.emplace(m_keys.emplace_back(value), offset);
+
+        return offset;
+    }
+
+    void StringCache::clear()
+    {
+        m_strings.clear();
+        m_keys.clear();
+    }
+
+    std::uint64_t StringCache::getHits() const
+    {
+        return m_hits;
+    }
+
+    std::uint64_t StringCache::getMisses() const
+    {
+        return m_misses;
+    }
+
+    std::size_t StringCache::getSize() const
+    {
+        return m_strings.size();
+    }
+}
+
+std::unique_ptr<Luna::StringCache> gStringCache;
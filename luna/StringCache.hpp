@@ -0,0 +1,61 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <engine/Common.hpp>
+
+#include <cinttypes>
+#include <deque>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace Luna
+{
+    /**
+     * @brief Interns strings passed to the engine string pool.
+     *
+     * Identical strings are allocated once per map instead of growing the
+     * engine pool on every call. Keys are copies of the strings as passed in,
+     * the engine's copy may differ (escapes, embedded NULs) and would never
+     * match. The cache must be cleared whenever the engine drops its strings
+     * (map change).
+     */
+    class StringCache
+    {
+    public:
+        [[nodiscard]] Anubis::Engine::StringOffset alloc(std::string_view value);
+        void clear();
+
+        [[nodiscard]] std::uint64_t getHits() const;
+        [[nodiscard]] std::uint64_t getMisses() const;
+        [[nodiscard]] std::size_t getSize() const;
+
+    private:
+        // Owns the key storage, a deque does not move its elements when growing
+        std::deque<std::string> m_keys;
+        std::unordered_map<std::string_view, Anubis::Engine::StringOffset> m_strings;
+        std::uint64_t m_hits{};
+        std::uint64_t m_misses{};
+    };
+}
+
+extern std::unique_ptr<Luna::StringCache> gStringCache;
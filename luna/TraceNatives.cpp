@@ -0,0 +1,228 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TraceNatives.hpp"
+#include "TracePool.hpp"
+#include "EntityHandle.hpp"
+#include "VisibilityCache.hpp"
+
+#include <engine/ITraceResult.hpp>
+
+#include <algorithm>
+#include <array>
+#include <optional>
+
+// fraction, end x, end y, end z, hit, hit group
+static constexpr lua_Integer TRACE_RESULT_STRIDE = 6;
+static constexpr lua_Integer TRACE_RAY_STRIDE = 6;
+
+static void readRay(lua_State *L, int arg, lua_Integer base, std::array<float, 3> &start, std::array<float, 3> &end)
+{
+    for (lua_Integer i = 0; i < 3; i++)
+    {
+        lua_rawgeti(L, arg, base + i);
+        start[static_cast<std::size_t>(i)] = static_cast<float>(lua_tonumber(L, -1));
+        lua_rawgeti(L, arg, base + 3 + i);
+        end[static_cast<std::size_t>(i)] = static_cast<float>(lua_tonumber(L, -1));
+        lua_pop(L, 2);
+    }
+}
+
+static void writeResult(lua_State *L, lua_Integer base, const Luna::TracePool::Lease &tr)
+{
+    lua_pushnumber(L, tr->getFraction());
+    lua_rawseti(L, -2, base);
+
+    const float *endPos = tr->getEndPos();
+    for (lua_Integer i = 0; i < 3; i++)
+    {
+        lua_pushnumber(L, endPos[i]);
+        lua_rawseti(L, -2, base + 1 + i);
+    }
+
+    // A flat array cannot hold nil, so no hit is reported as false
+    nstd::observer_ptr<Anubis::Engine::IEdict> hit = tr->getHit();
+    if (hit)
+    {
+        Luna::pushEdict(L, hit);
+    }
+    else
+    {
+        lua_pushboolean(L, 0);
+    }
+    lua_rawseti(L, -2, base + 4);
+
+    lua_pushinteger(L, static_cast<lua_Integer>(tr->getHitGroup()));
+    lua_rawseti(L, -2, base + 5);
+}
+
+/*
+ * Rays are a flat array of start and end coordinates, six numbers per ray.
+ * Results are written to the table at outArg (or a new one), six values per ray:
+ * fraction, end position, hit entity or false, hit group.
+ */
+static int traceBatch(lua_State *L, int skipArg, int outArg,
+                      Anubis::Engine::TraceMonsters traceMonsters, std::optional<Anubis::Engine::HullNumber> hull)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    auto rays = static_cast<lua_Integer>(lua_rawlen(L, 1)) / TRACE_RAY_STRIDE;
+    nstd::observer_ptr<Anubis::Engine::IEdict> skip = Luna::toEdict(L, skipArg);
+
+    lua_Integer oldLength = 0;
+    if (lua_istable(L, outArg))
+    {
+        lua_pushvalue(L, outArg);
+        oldLength = static_cast<lua_Integer>(lua_rawlen(L, -1));
+    }
+    else
+    {
+        lua_createtable(L, static_cast<int>(rays * TRACE_RESULT_STRIDE), 0);
+    }
+
+    Luna::TracePool::Lease tr = gTracePool->acquire();
+    std::array<float, 3> start {};
+    std::array<float, 3> end {};
+
+    for (lua_Integer ray = 0; ray < rays; ray++)
+    {
+        readRay(L, 1, ray * TRACE_RAY_STRIDE + 1, start, end);
+
+        if (hull)
+        {
+            gEngine->traceHull(start, end, traceMonsters, *hull, skip, tr.get(), Anubis::FuncCallType::Direct);
+        }
+        else
+        {
+            gEngine->traceLine(start, end, traceMonsters, skip, tr.get(), Anubis::FuncCallType::Direct);
+        }
+
+        writeResult(L, ray * TRACE_RESULT_STRIDE + 1, tr);
+    }
+
+    for (lua_Integer i = rays * TRACE_RESULT_STRIDE + 1; i <= oldLength; i++)
+    {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+
+    lua_pushinteger(L, rays);
+    return 2;
+}
+
+static int traceLines(lua_State *L)
+{
+    auto traceMonsters = static_cast<Anubis::Engine::TraceMonsters>(luaL_checkinteger(L, 2));
+
+    return traceBatch(L, 3, 4, traceMonsters, std::nullopt);
+}
+
+static int traceHulls(lua_State *L)
+{
+    auto traceMonsters = static_cast<Anubis::Engine::TraceMonsters>(luaL_checkinteger(L, 2));
+    auto hull = static_cast<Anubis::Engine::HullNumber>(luaL_checkinteger(L, 3));
+
+    return traceBatch(L, 4, 5, traceMonsters, hull);
+}
+
+static std::uint32_t checkPlayerIndex(lua_State *L, int arg)
+{
+    nstd::observer_ptr<Anubis::Engine::IEdict> edict = Luna::checkEdict(L, arg);
+    std::uint32_t index = edict->getIndex();
+
+    luaL_argcheck(L, index >= 1 && index <= Luna::VisibilityCache::MAX_PLAYERS && index <= gEngine->getMaxClients(),
+                  arg, "entity is not a player");
+
+    return index;
+}
+
+static int isPlayerVisible(lua_State *L)
+{
+    std::uint32_t first = checkPlayerIndex(L, 1);
+    std::uint32_t second = checkPlayerIndex(L, 2);
+
+    lua_pushboolean(L, static_cast<int>(gVisibilityCache->isVisible(first, second)));
+    return 1;
+}
+
+static int getVisiblePlayers(lua_State *L)
+{
+    using Anubis::Engine::IEdict;
+
+    std::uint32_t player = checkPlayerIndex(L, 1);
+    std::uint32_t maxClients = std::min(gEngine->getMaxClients(), Luna::VisibilityCache::MAX_PLAYERS);
+
+    lua_Integer oldLength = 0;
+    if (lua_istable(L, 2))
+    {
+        lua_pushvalue(L, 2);
+        oldLength = static_cast<lua_Integer>(lua_rawlen(L, -1));
+    }
+    else
+    {
+        lua_createtable(L, static_cast<int>(maxClients), 0);
+    }
+
+    lua_Integer count = 0;
+    for (std::uint32_t i = 1; i <= maxClients; i++)
+    {
+        if (i == player)
+        {
+            continue;
+        }
+
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(i, Anubis::FuncCallType::Direct);
+        if (!edict || edict->isFree() ||
+            !(static_cast<std::uint32_t>(edict->getFlags()) & static_cast<std::uint32_t>(IEdict::Flag::Client)))
+        {
+            continue;
+        }
+
+        if (gVisibilityCache->isVisible(player, i))
+        {
+            Luna::pushEdict(L, edict);
+            lua_rawseti(L, -2, ++count);
+        }
+    }
+
+    for (lua_Integer i = count + 1; i <= oldLength; i++)
+    {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+
+    lua_pushinteger(L, count);
+    return 2;
+}
+
+static int getVisibilityStats(lua_State *L)
+{
+    lua_pushinteger(L, static_cast<lua_Integer>(gVisibilityCache->getHits()));
+    lua_pushinteger(L, static_cast<lua_Integer>(gVisibilityCache->getTraces()));
+    return 2;
+}
+
+LuaAdapterCFunction gTraceNatives[] = {
+    {"traceLines", traceLines},
+    {"traceHulls", traceHulls},
+    {"isPlayerVisible", isPlayerVisible},
+    {"getVisiblePlayers", getVisiblePlayers},
+    {"getVisibilityStats", getVisibilityStats},
+    {nullptr, nullptr}
+};
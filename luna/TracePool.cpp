@@ -0,0 +1,63 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TracePool.hpp"
+#include "AnubisExports.hpp"
+
+namespace Luna
+{
+    TracePool::Lease::Lease(TracePool &pool, std::unique_ptr<Anubis::Engine::ITraceResult> &&result)
+        : m_pool(pool), m_result(std::move(result)) {}
+
+    TracePool::Lease::~Lease()
+    {
+        m_pool.m_free.emplace_back(std::move(m_result));
+    }
+
+    nstd::observer_ptr<Anubis::Engine::ITraceResult> TracePool::Lease::get() const
+    {
+        return m_result;
+    }
+
+    Anubis::Engine::ITraceResult *TracePool::Lease::operator->() const
+    {
+        return m_result.get();
+    }
+
+    TracePool::Lease TracePool::acquire()
+    {
+        if (m_free.empty())
+        {
+            m_allocated++;
+            return {*this, gEngine->createTraceResult()};
+        }
+
+        std::unique_ptr<Anubis::Engine::ITraceResult> result = std::move(m_free.back());
+        m_free.pop_back();
+
+        return {*this, std::move(result)};
+    }
+
+    std::size_t TracePool::getAllocated() const
+    {
+        return m_allocated;
+    }
+}
+
+std::unique_ptr<Luna::TracePool> gTracePool;
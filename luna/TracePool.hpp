@@ -0,0 +1,66 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <engine/ITraceResult.hpp>
+
+#include <memory>
+#include <vector>
+
+namespace Luna
+{
+    /**
+     * @brief Reuses ITraceResult objects across traces.
+     *
+     * Results are leased for the duration of a trace batch and returned to the
+     * free list when the lease goes out of scope, so nested users (hooks firing
+     * during a batch) each get their own object.
+     */
+    class TracePool
+    {
+    public:
+        class Lease
+        {
+        public:
+            Lease(TracePool &pool, std::unique_ptr<Anubis::Engine::ITraceResult> &&result);
+            Lease(const Lease &) = delete;
+            Lease &operator=(const Lease &) = delete;
+            ~Lease();
+
+            [[nodiscard]] nstd::observer_ptr<Anubis::Engine::ITraceResult> get() const;
+            Anubis::Engine::ITraceResult *operator->() const;
+
+        private:
+            TracePool &m_pool;
+            std::unique_ptr<Anubis::Engine::ITraceResult> m_result;
+        };
+
+    public:
+        [[nodiscard]] Lease acquire();
+
+        [[nodiscard]] std::size_t getAllocated() const;
+
+    private:
+        std::vector<std::unique_ptr<Anubis::Engine::ITraceResult>> m_free;
+        std::size_t m_allocated{};
+    };
+}
+
+extern std::unique_ptr<Luna::TracePool> gTracePool;
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TweenNatives.hpp"
+#include "EntityHandle.hpp"
+#include "TweenSystem.hpp"
+#include "Vec3Natives.hpp"
+
+#include <engine/IEdict.hpp>
+
+// Reads duration [, easing [, callback]] starting at arg and starts the tween
+static int startTween(lua_State *L, Luna::TweenSystem::Target &target, int arg)
+{
+    using Luna::TweenSystem;
+
+    target.duration = static_cast<float>(luaL_checknumber(L, arg));
+    auto easing = luaL_optinteger(L, arg + 1, static_cast<lua_Integer>(TweenSystem::Easing::Linear));
+    const char *callback = luaL_optstring(L, arg + 2, "");
+
+    luaL_argcheck(L, target.duration >= 0.0f, arg, "duration cannot be negative");
+    luaL_argcheck(L, easing >= 0 && easing <= static_cast<lua_Integer>(TweenSystem::Easing::SineInOut), arg + 1,
+                  "invalid easing");
+
+    target.easing = static_cast<TweenSystem::Easing>(easing);
+
+    if (TweenSystem::ID id = gTweenSystem->tween(L, target, callback); id)
+    {
+        lua_pushinteger(L, id);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+
+    return 1;
+}
+
+// tweenFloatProperty(edict, property, end, duration [, easing [, callback]])
+static int tweenFloatProperty(lua_State *L)
+{
+    auto edict = Luna::checkEdict(L, 1);
+    auto property = luaL_checkinteger(L, 2);
+    auto end = static_cast<float>(luaL_checknumber(L, 3));
+
+    luaL_argcheck(L, property >= 0 && property <= static_cast<lua_Integer>(Anubis::Engine::IEdict::FlProperty::User4),
+                  2, "invalid property");
+
+    Luna::TweenSystem::Target target {};
+    target.index = edict->getIndex();
+    target.kind = Luna::TweenSystem::Kind::Float;
+    target.property = static_cast<std::uint8_t>(property);
+    target.end[0] = end;
+
+    return startTween(L, target, 4);
+}
+
+// tweenVecProperty(edict, property, end, duration [, easing [, callback]]), end is a Vec3 or x, y, z
+static int tweenVecProperty(lua_State *L)
+{
+    auto edict = Luna::checkEdict(L, 1);
+    auto property = luaL_checkinteger(L, 2);
+
+    luaL_argcheck(L, property >= 0 && property <= static_cast<lua_Integer>(Anubis::Engine::IEdict::VecProperty::User4),
+                  2, "invalid property");
+
+    Luna::TweenSystem::Target target {};
+    target.index = edict->getIndex();
+    target.kind = Luna::TweenSystem::Kind::Vec;
+    target.property = static_cast<std::uint8_t>(property);
+
+    return startTween(L, target, Luna::getVec3Args(L, 3, target.end));
+}
+
+static int cancelTween(lua_State *L)
+{
+    lua_pushboolean(L, gTweenSystem->cancel(L, static_cast<Luna::TweenSystem::ID>(luaL_checkinteger(L, 1))));
+    return 1;
+}
+
+static int getActiveTweens(lua_State *L)
+{
+    lua_pushinteger(L, static_cast<lua_Integer>(gTweenSystem->getActive()));
+    return 1;
+}
+
+LuaAdapterCFunction gTweenNatives[] = {
+    {"tweenFloatProperty", tweenFloatProperty},
+    {"tweenVecProperty", tweenVecProperty},
+    {"cancelTween", cancelTween},
+    {"getActiveTweens", getActiveTweens},
+    {nullptr, nullptr}
+};
@@ -0,0 +1,253 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "TweenSystem.hpp"
+#include "AnubisExports.hpp"
+#include "EntityHandle.hpp"
+#include "SpatialIndex.hpp"
+
+#include <engine/IEdict.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Luna
+{
+    TweenSystem::ID TweenSystem::tween(lua_State *L, const Target &target, std::string_view callback)
+    {
+        using Anubis::Engine::IEdict;
+
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(target.index, Anubis::FuncCallType::Direct);
+
+        // Completion runs on the main thread, the coroutine starting the tween may be gone by then
+        L = getMainThread(L);
+
+        Tween tween {m_nextId++, static_cast<std::uint16_t>(target.index), target.kind, target.property,
+                     target.easing, edict->getSerialNumber(), gEngine->getTime(), target.duration, {}, target.end,
+                     L, std::string {callback}};
+
+        if (target.kind == Kind::Float)
+        {
+            tween.start[0] = edict->getFlProperty(static_cast<IEdict::FlProperty>(target.property));
+        }
+        else
+        {
+            tween.start = edict->getVecProperty(static_cast<IEdict::VecProperty>(target.property));
+        }
+
+        auto iter = std::find_if(m_tweens.begin(), m_tweens.end(),
+                                 [&tween](const Tween &other)
+                                 {
+                                     return other.index == tween.index && other.kind == tween.kind &&
+                                            other.property == tween.property;
+                                 });
+
+        if (iter != m_tweens.end())
+        {
+            // Replacing it would drop the other plugin's callback
+            if (iter->L != L)
+            {
+                return 0;
+            }
+
+            *iter = std::move(tween);
+            return iter->id;
+        }
+
+        m_tweens.push_back(std::move(tween));
+        return m_tweens.back().id;
+    }
+
+    bool TweenSystem::cancel(lua_State *L, ID id)
+    {
+        lua_State *owner = getMainThread(L);
+        auto iter = std::find_if(m_tweens.begin(), m_tweens.end(),
+                                 [id, owner](const Tween &tween)
+                                 {
+                                     return tween.id == id && tween.L == owner;
+                                 });
+
+        if (iter == m_tweens.end())
+        {
+            return false;
+        }
+
+        if (std::next(iter) != m_tweens.end())
+        {
+            *iter = std::move(m_tweens.back());
+        }
+
+        m_tweens.pop_back();
+
+        return true;
+    }
+
+    void TweenSystem::cancelAll(lua_State *L)
+    {
+        m_tweens.erase(std::remove_if(m_tweens.begin(), m_tweens.end(),
+                                      [L](const Tween &tween)
+                                      {
+                                          return tween.L == L;
+                                      }),
+                       m_tweens.end());
+    }
+
+    void TweenSystem::update()
+    {
+        const float now = gEngine->getTime();
+
+        for (std::size_t i = 0; i < m_tweens.size();)
+        {
+            Tween &tween = m_tweens[i];
+
+            float t = tween.duration > 0.0f ? (now - tween.startTime) / tween.duration : 1.0f;
+            t = std::clamp(t, 0.0f, 1.0f);
+
+            bool alive = _apply(tween, _ease(tween.easing, t));
+
+            if (alive && t < 1.0f)
+            {
+                i++;
+                continue;
+            }
+
+            if (alive && !tween.callback.empty())
+            {
+                m_completed.push_back({tween.id, tween.index, tween.serialNumber, tween.L, std::move(tween.callback)});
+            }
+
+            if (i + 1 != m_tweens.size())
+            {
+                tween = std::move(m_tweens.back());
+            }
+
+            m_tweens.pop_back();
+        }
+
+        // Callbacks may start new tweens, so they run only once the pass is over
+        for (const Completion &completion : m_completed)
+        {
+            _complete(completion);
+        }
+
+        m_completed.clear();
+    }
+
+    std::size_t TweenSystem::getActive() const
+    {
+        return m_tweens.size();
+    }
+
+    float TweenSystem::_ease(Easing easing, float t)
+    {
+        switch (easing)
+        {
+            case Easing::Linear:
+                return t;
+            case Easing::QuadIn:
+                return t * t;
+            case Easing::QuadOut:
+                return t * (2.0f - t);
+            case Easing::QuadInOut:
+                return t < 0.5f ? 2.0f * t * t : -1.0f + (4.0f - 2.0f * t) * t;
+            case Easing::CubicIn:
+                return t * t * t;
+            case Easing::CubicOut:
+            {
+                float f = t - 1.0f;
+                return f * f * f + 1.0f;
+            }
+            case Easing::CubicInOut:
+            {
+                if (t < 0.5f)
+                {
+                    return 4.0f * t * t * t;
+                }
+
+                float f = 2.0f * t - 2.0f;
+                return 0.5f * f * f * f + 1.0f;
+            }
+            case Easing::SineInOut:
+                return 0.5f * (1.0f - std::cos(t * 3.14159265f));
+        }
+
+        return t;
+    }
+
+    bool TweenSystem::_apply(const Tween &tween, float t)
+    {
+        using Anubis::Engine::IEdict;
+
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(tween.index, Anubis::FuncCallType::Direct);
+
+        if (!edict || edict->isFree() || edict->getSerialNumber() != tween.serialNumber)
+        {
+            return false;
+        }
+
+        if (tween.kind == Kind::Float)
+        {
+            edict->setFlProperty(static_cast<IEdict::FlProperty>(tween.property),
+                                 tween.start[0] + (tween.end[0] - tween.start[0]) * t);
+            return true;
+        }
+
+        std::array<float, 3> value {};
+        for (std::size_t i = 0; i < value.size(); i++)
+        {
+            value[i] = tween.start[i] + (tween.end[i] - tween.start[i]) * t;
+        }
+
+        auto property = static_cast<IEdict::VecProperty>(tween.property);
+
+        // Origin has to be relinked by the engine
+        if (property == IEdict::VecProperty::Origin)
+        {
+            gEngine->setOrigin(edict, value, Anubis::FuncCallType::Direct);
+            gSpatialIndex->markDirty(tween.index);
+        }
+        else
+        {
+            edict->setVecProperty(property, value);
+        }
+
+        return true;
+    }
+
+    void TweenSystem::_complete(const Completion &completion)
+    {
+        lua_State *L = completion.L;
+
+        if (lua_getglobal(L, completion.callback.c_str()) == LUA_TNIL)
+        {
+            lua_pop(L, 1);
+            return;
+        }
+
+        lua_pushinteger(L, makeEdictHandle(completion.index, completion.serialNumber));
+        lua_pushinteger(L, completion.id);
+
+        if (lua_pcall(L, 2, 0, 0) != LUA_OK)
+        {
+            lua_pop(L, 1);
+        }
+    }
+}
+
+std::unique_ptr<Luna::TweenSystem> gTweenSystem;
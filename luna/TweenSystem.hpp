@@ -0,0 +1,121 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "CommonNatives.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Luna
+{
+    /**
+     * @brief Interpolates entity properties natively every frame.
+     *
+     * Each tween moves one float or vector property from its value at start to
+     * the end value over the given duration. Starting a tween on a property
+     * that the plugin already tweens replaces the old one, a property tweened
+     * by another plugin is refused. The completion callback runs once, after
+     * all tweens of the frame were applied.
+     */
+    class TweenSystem
+    {
+    public:
+        enum class Kind : std::uint8_t
+        {
+            Float = 0,
+            Vec
+        };
+
+        enum class Easing : std::uint8_t
+        {
+            Linear = 0,
+            QuadIn,
+            QuadOut,
+            QuadInOut,
+            CubicIn,
+            CubicOut,
+            CubicInOut,
+            SineInOut
+        };
+
+        using ID = std::uint32_t;
+
+        struct Target
+        {
+            std::uint32_t index;
+            Kind kind;
+            std::uint8_t property;
+            std::array<float, 3> end;
+            float duration;
+            Easing easing;
+        };
+
+    public:
+        // Returns 0 when another plugin tweens the property
+        ID tween(lua_State *L, const Target &target, std::string_view callback);
+        bool cancel(lua_State *L, ID id);
+        void cancelAll(lua_State *L);
+        void update();
+
+        [[nodiscard]] std::size_t getActive() const;
+
+    private:
+        struct Tween
+        {
+            ID id;
+            std::uint16_t index;
+            Kind kind;
+            std::uint8_t property;
+            Easing easing;
+            std::uint32_t serialNumber;
+            float startTime;
+            float duration;
+            std::array<float, 3> start;
+            std::array<float, 3> end;
+            lua_State *L;
+            std::string callback;
+        };
+
+        struct Completion
+        {
+            ID id;
+            std::uint16_t index;
+            std::uint32_t serialNumber;
+            lua_State *L;
+            std::string callback;
+        };
+
+    private:
+        [[nodiscard]] static float _ease(Easing easing, float t);
+        [[nodiscard]] static bool _apply(const Tween &tween, float t);
+        static void _complete(const Completion &completion);
+
+    private:
+        std::vector<Tween> m_tweens;
+        std::vector<Completion> m_completed;
+        ID m_nextId = 1;
+    };
+}
+
+extern std::unique_ptr<Luna::TweenSystem> gTweenSystem;
@@ -0,0 +1,644 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Vec3Natives.hpp"
+#include "VecMath.hpp"
+#include "SnapshotSystem.hpp"
+
+#include <cmath>
+#include <vector>
+
+static constexpr const char *VEC3_MT = "LunaVec3";
+
+// Keeps vecDistanceMatrix at a few MB of scratch and a million table entries
+static constexpr std::size_t MAX_MATRIX_VECTORS = 1024;
+
+static std::vector<float> gVecScratch;
+
+static Luna::Vec3 *newVec3(lua_State *L, float x, float y, float z);
+
+static int vec3Index(lua_State *L)
+{
+    auto vec = reinterpret_cast<Luna::Vec3 *>(lua_touserdata(L, 1));
+
+    size_t length;
+    const char *key = lua_tolstring(L, 2, &length);
+
+    if (key && length == 1)
+    {
+        switch (key[0])
+        {
+            case 'x':
+                lua_pushnumber(L, vec->x);
+                return 1;
+            case 'y':
+                lua_pushnumber(L, vec->y);
+                return 1;
+            case 'z':
+                lua_pushnumber(L, vec->z);
+                return 1;
+            default:
+                break;
+        }
+    }
+
+    // Methods table is the upvalue
+    lua_pushvalue(L, 2);
+    lua_rawget(L, lua_upvalueindex(1));
+    return 1;
+}
+
+static int vec3NewIndex(lua_State *L)
+{
+    auto vec = reinterpret_cast<Luna::Vec3 *>(lua_touserdata(L, 1));
+
+    size_t length;
+    const char *key = luaL_checklstring(L, 2, &length);
+    auto value = static_cast<float>(luaL_checknumber(L, 3));
+
+    if (length == 1)
+    {
+        switch (key[0])
+        {
+            case 'x':
+                vec->x = value;
+                return 0;
+            case 'y':
+                vec->y = value;
+                return 0;
+            case 'z':
+                vec->z = value;
+                return 0;
+            default:
+                break;
+        }
+    }
+
+    return luaL_error(L, "Vec3 has no field '%s'", key);
+}
+
+static int vec3Add(lua_State *L)
+{
+    Luna::Vec3 *a = Luna::checkVec3(L, 1);
+    Luna::Vec3 *b = Luna::checkVec3(L, 2);
+
+    newVec3(L, a->x + b->x, a->y + b->y, a->z + b->z);
+    return 1;
+}
+
+static int vec3Sub(lua_State *L)
+{
+    Luna::Vec3 *a = Luna::checkVec3(L, 1);
+    Luna::Vec3 *b = Luna::checkVec3(L, 2);
+
+    newVec3(L, a->x - b->x, a->y - b->y, a->z - b->z);
+    return 1;
+}
+
+static int vec3Mul(lua_State *L)
+{
+    if (lua_isnumber(L, 1))
+    {
+        auto scalar = static_cast<float>(lua_tonumber(L, 1));
+        Luna::Vec3 *vec = Luna::checkVec3(L, 2);
+
+        newVec3(L, vec->x * scalar, vec->y * scalar, vec->z * scalar);
+        return 1;
+    }
+
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    if (lua_isnumber(L, 2))
+    {
+        auto scalar = static_cast<float>(lua_tonumber(L, 2));
+
+        newVec3(L, vec->x * scalar, vec->y * scalar, vec->z * scalar);
+        return 1;
+    }
+
+    Luna::Vec3 *other = Luna::checkVec3(L, 2);
+
+    newVec3(L, vec->x * other->x, vec->y * other->y, vec->z * other->z);
+    return 1;
+}
+
+static int vec3Div(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+    auto scalar = static_cast<float>(luaL_checknumber(L, 2));
+
+    newVec3(L, vec->x / scalar, vec->y / scalar, vec->z / scalar);
+    return 1;
+}
+
+static int vec3Unm(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    newVec3(L, -vec->x, -vec->y, -vec->z);
+    return 1;
+}
+
+static int vec3Eq(lua_State *L)
+{
+    Luna::Vec3 *a = Luna::checkVec3(L, 1);
+    Luna::Vec3 *b = Luna::checkVec3(L, 2);
+
+    lua_pushboolean(L, a->x == b->x && a->y == b->y && a->z == b->z);
+    return 1;
+}
+
+static int vec3Length(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    lua_pushnumber(L, std::sqrt(vec->x * vec->x + vec->y * vec->y + vec->z * vec->z));
+    return 1;
+}
+
+static int vec3LengthSq(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    lua_pushnumber(L, vec->x * vec->x + vec->y * vec->y + vec->z * vec->z);
+    return 1;
+}
+
+static int vec3ToString(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    lua_pushfstring(L, "Vec3(%f, %f, %f)", static_cast<lua_Number>(vec->x), static_cast<lua_Number>(vec->y),
+                    static_cast<lua_Number>(vec->z));
+    return 1;
+}
+
+static int vec3Unpack(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    lua_pushnumber(L, vec->x);
+    lua_pushnumber(L, vec->y);
+    lua_pushnumber(L, vec->z);
+    return 3;
+}
+
+static int vec3Copy(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    newVec3(L, vec->x, vec->y, vec->z);
+    return 1;
+}
+
+static int vec3Distance(lua_State *L)
+{
+    Luna::Vec3 *a = Luna::checkVec3(L, 1);
+    Luna::Vec3 *b = Luna::checkVec3(L, 2);
+
+    float x = a->x - b->x;
+    float y = a->y - b->y;
+    float z = a->z - b->z;
+
+    lua_pushnumber(L, std::sqrt(x * x + y * y + z * z));
+    return 1;
+}
+
+static int vec3Dot(lua_State *L)
+{
+    Luna::Vec3 *a = Luna::checkVec3(L, 1);
+    Luna::Vec3 *b = Luna::checkVec3(L, 2);
+
+    lua_pushnumber(L, a->x * b->x + a->y * b->y + a->z * b->z);
+    return 1;
+}
+
+static int vec3Cross(lua_State *L)
+{
+    Luna::Vec3 *a = Luna::checkVec3(L, 1);
+    Luna::Vec3 *b = Luna::checkVec3(L, 2);
+
+    newVec3(L, a->y * b->z - a->z * b->y, a->z * b->x - a->x * b->z, a->x * b->y - a->y * b->x);
+    return 1;
+}
+
+static int vec3Normalized(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+    float length = std::sqrt(vec->x * vec->x + vec->y * vec->y + vec->z * vec->z);
+
+    if (length > 0.0f)
+    {
+        newVec3(L, vec->x / length, vec->y / length, vec->z / length);
+    }
+    else
+    {
+        newVec3(L, 0.0f, 0.0f, 0.0f);
+    }
+
+    return 1;
+}
+
+static int vec3Set(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+
+    std::array<float, 3> value {};
+    Luna::getVec3Args(L, 2, value);
+
+    vec->x = value[0];
+    vec->y = value[1];
+    vec->z = value[2];
+
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int vec3AddInPlace(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+    Luna::Vec3 *other = Luna::checkVec3(L, 2);
+
+    vec->x += other->x;
+    vec->y += other->y;
+    vec->z += other->z;
+
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int vec3SubInPlace(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+    Luna::Vec3 *other = Luna::checkVec3(L, 2);
+
+    vec->x -= other->x;
+    vec->y -= other->y;
+    vec->z -= other->z;
+
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int vec3ScaleInPlace(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+    auto scalar = static_cast<float>(luaL_checknumber(L, 2));
+
+    vec->x *= scalar;
+    vec->y *= scalar;
+    vec->z *= scalar;
+
+    lua_settop(L, 1);
+    return 1;
+}
+
+static int vec3NormalizeInPlace(lua_State *L)
+{
+    Luna::Vec3 *vec = Luna::checkVec3(L, 1);
+    float length = std::sqrt(vec->x * vec->x + vec->y * vec->y + vec->z * vec->z);
+
+    if (length > 0.0f)
+    {
+        vec->x /= length;
+        vec->y /= length;
+        vec->z /= length;
+    }
+
+    lua_settop(L, 1);
+    return 1;
+}
+
+static const luaL_Reg gVec3Methods[] = {
+    {"unpack", vec3Unpack},
+    {"copy", vec3Copy},
+    {"length", vec3Length},
+    {"lengthSq", vec3LengthSq},
+    {"distance", vec3Distance},
+    {"dot", vec3Dot},
+    {"cross", vec3Cross},
+    {"normalized", vec3Normalized},
+    {"set", vec3Set},
+    {"add", vec3AddInPlace},
+    {"sub", vec3SubInPlace},
+    {"scale", vec3ScaleInPlace},
+    {"normalize", vec3NormalizeInPlace},
+    {nullptr, nullptr}
+};
+
+static const luaL_Reg gVec3Metamethods[] = {
+    {"__newindex", vec3NewIndex},
+    {"__add", vec3Add},
+    {"__sub", vec3Sub},
+    {"__mul", vec3Mul},
+    {"__div", vec3Div},
+    {"__unm", vec3Unm},
+    {"__eq", vec3Eq},
+    {"__len", vec3Length},
+    {"__tostring", vec3ToString},
+    {nullptr, nullptr}
+};
+
+static Luna::Vec3 *newVec3(lua_State *L, float x, float y, float z)
+{
+    auto vec = reinterpret_cast<Luna::Vec3 *>(lua_newuserdatauv(L, sizeof(Luna::Vec3), 0));
+    vec->x = x;
+    vec->y = y;
+    vec->z = z;
+
+    if (luaL_newmetatable(L, VEC3_MT))
+    {
+        luaL_setfuncs(L, gVec3Metamethods, 0);
+
+        lua_newtable(L);
+        luaL_setfuncs(L, gVec3Methods, 0);
+        lua_pushcclosure(L, vec3Index, 1);
+        lua_setfield(L, -2, "__index");
+    }
+
+    lua_setmetatable(L, -2);
+    return vec;
+}
+
+// Pushes the table passed at arg, or a new one sized for count entries. Returns the previous length.
+static lua_Integer pushOutTable(lua_State *L, int arg, std::size_t count)
+{
+    if (lua_istable(L, arg))
+    {
+        lua_pushvalue(L, arg);
+        return static_cast<lua_Integer>(lua_rawlen(L, -1));
+    }
+
+    lua_createtable(L, static_cast<int>(count), 0);
+    return 0;
+}
+
+static void trimOutTable(lua_State *L, std::size_t count, lua_Integer oldLength)
+{
+    for (auto i = static_cast<lua_Integer>(count) + 1; i <= oldLength; i++)
+    {
+        lua_pushnil(L);
+        lua_rawseti(L, -2, i);
+    }
+}
+
+// Copies a table of Vec3 into three columns of gVecScratch starting at offset
+static std::size_t gatherVec3Array(lua_State *L, int arg, std::size_t offset, std::size_t stride)
+{
+    auto count = static_cast<std::size_t>(lua_rawlen(L, arg));
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        lua_rawgeti(L, arg, static_cast<lua_Integer>(i + 1));
+        Luna::Vec3 *vec = Luna::toVec3(L, -1);
+
+        if (!vec)
+        {
+            luaL_error(L, "element %d of argument #%d is not a Vec3", static_cast<int>(i + 1), arg);
+        }
+
+        gVecScratch[offset + i] = vec->x;
+        gVecScratch[offset + stride + i] = vec->y;
+        gVecScratch[offset + stride * 2 + i] = vec->z;
+
+        lua_pop(L, 1);
+    }
+
+    return count;
+}
+
+static int createVec3(lua_State *L)
+{
+    newVec3(L, static_cast<float>(luaL_optnumber(L, 1, 0.0)), static_cast<float>(luaL_optnumber(L, 2, 0.0)),
+            static_cast<float>(luaL_optnumber(L, 3, 0.0)));
+    return 1;
+}
+
+static int vecDistanceMatrix(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    auto count = static_cast<std::size_t>(lua_rawlen(L, 1));
+    luaL_argcheck(L, count <= MAX_MATRIX_VECTORS, 1, "too many vectors");
+
+    gVecScratch.resize(count * 3 + count * count);
+    gatherVec3Array(L, 1, 0, count);
+
+    float *matrix = gVecScratch.data() + count * 3;
+    Luna::VecMath::distanceMatrix(gVecScratch.data(), gVecScratch.data() + count, gVecScratch.data() + count * 2,
+                                  count, matrix);
+
+    lua_Integer oldLength = pushOutTable(L, 2, count * count);
+    for (std::size_t i = 0; i < count * count; i++)
+    {
+        lua_pushnumber(L, matrix[i]);
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+
+    trimOutTable(L, count * count, oldLength);
+
+    lua_pushinteger(L, static_cast<lua_Integer>(count));
+    return 2;
+}
+
+static int playerDistanceMatrix(lua_State *L)
+{
+    using Column = Luna::PlayerSnapshot::Column;
+
+    if (!gPlayerSnapshot->isCaptured(Column::OriginX))
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    std::size_t count = gPlayerSnapshot->getMaxClients();
+    gVecScratch.resize(count * count);
+
+    // Snapshot columns are indexed by edict index, slot 0 is unused
+    Luna::VecMath::distanceMatrix(gPlayerSnapshot->getFloatColumn(Column::OriginX) + 1,
+                                  gPlayerSnapshot->getFloatColumn(Column::OriginY) + 1,
+                                  gPlayerSnapshot->getFloatColumn(Column::OriginZ) + 1,
+                                  count, gVecScratch.data());
+
+    // Slots without a connected player keep their last origin, their distances are false
+    const std::int32_t *connected = gPlayerSnapshot->getIntColumn(Column::Connected) + 1;
+
+    lua_Integer oldLength = pushOutTable(L, 1, count * count);
+    for (std::size_t i = 0; i < count * count; i++)
+    {
+        if (connected[i / count] && connected[i % count])
+        {
+            lua_pushnumber(L, gVecScratch[i]);
+        }
+        else
+        {
+            lua_pushboolean(L, false);
+        }
+
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+
+    trimOutTable(L, count * count, oldLength);
+
+    lua_pushinteger(L, static_cast<lua_Integer>(count));
+    return 2;
+}
+
+static int vecNormalizeArray(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+
+    auto count = static_cast<std::size_t>(lua_rawlen(L, 1));
+    gVecScratch.resize(count * 3);
+    gatherVec3Array(L, 1, 0, count);
+
+    Luna::VecMath::normalize(gVecScratch.data(), gVecScratch.data() + count, gVecScratch.data() + count * 2, count);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        lua_rawgeti(L, 1, static_cast<lua_Integer>(i + 1));
+        auto vec = reinterpret_cast<Luna::Vec3 *>(lua_touserdata(L, -1));
+
+        vec->x = gVecScratch[i];
+        vec->y = gVecScratch[count + i];
+        vec->z = gVecScratch[count * 2 + i];
+
+        lua_pop(L, 1);
+    }
+
+    lua_pushinteger(L, static_cast<lua_Integer>(count));
+    return 1;
+}
+
+static std::size_t gatherVec3Pairs(lua_State *L)
+{
+    luaL_checktype(L, 1, LUA_TTABLE);
+    luaL_checktype(L, 2, LUA_TTABLE);
+
+    auto count = static_cast<std::size_t>(lua_rawlen(L, 1));
+    luaL_argcheck(L, static_cast<std::size_t>(lua_rawlen(L, 2)) == count, 2, "arrays must have the same length");
+
+    // a.xyz, b.xyz, then three output columns
+    gVecScratch.resize(count * 9);
+    gatherVec3Array(L, 1, 0, count);
+    gatherVec3Array(L, 2, count * 3, count);
+
+    return count;
+}
+
+static int vecDotArray(lua_State *L)
+{
+    std::size_t count = gatherVec3Pairs(L);
+    float *data = gVecScratch.data();
+    float *out = data + count * 6;
+
+    Luna::VecMath::dot(data, data + count, data + count * 2,
+                       data + count * 3, data + count * 4, data + count * 5,
+                       count, out);
+
+    lua_Integer oldLength = pushOutTable(L, 3, count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        lua_pushnumber(L, out[i]);
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+
+    trimOutTable(L, count, oldLength);
+    return 1;
+}
+
+static int vecCrossArray(lua_State *L)
+{
+    std::size_t count = gatherVec3Pairs(L);
+    float *data = gVecScratch.data();
+    float *out = data + count * 6;
+
+    Luna::VecMath::cross(data, data + count, data + count * 2,
+                         data + count * 3, data + count * 4, data + count * 5,
+                         count, out, out + count, out + count * 2);
+
+    lua_Integer oldLength = pushOutTable(L, 3, count);
+    for (std::size_t i = 0; i < count; i++)
+    {
+        // Reuse vectors already in the output table
+        lua_rawgeti(L, -1, static_cast<lua_Integer>(i + 1));
+        Luna::Vec3 *vec = Luna::toVec3(L, -1);
+
+        if (vec)
+        {
+            vec->x = out[i];
+            vec->y = out[count + i];
+            vec->z = out[count * 2 + i];
+            lua_pop(L, 1);
+            continue;
+        }
+
+        lua_pop(L, 1);
+        newVec3(L, out[i], out[count + i], out[count * 2 + i]);
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+
+    trimOutTable(L, count, oldLength);
+    return 1;
+}
+
+namespace Luna
+{
+    Vec3 *pushVec3(lua_State *L, const std::array<float, 3> &value)
+    {
+        return newVec3(L, value[0], value[1], value[2]);
+    }
+
+    Vec3 *toVec3(lua_State *L, int arg)
+    {
+        return reinterpret_cast<Vec3 *>(luaL_testudata(L, arg, VEC3_MT));
+    }
+
+    Vec3 *checkVec3(lua_State *L, int arg)
+    {
+        return reinterpret_cast<Vec3 *>(luaL_checkudata(L, arg, VEC3_MT));
+    }
+
+    int getVec3Args(lua_State *L, int arg, std::array<float, 3> &out)
+    {
+        if (Vec3 *vec = toVec3(L, arg))
+        {
+            out = {vec->x, vec->y, vec->z};
+            return arg + 1;
+        }
+
+        out = {
+            static_cast<float>(luaL_checknumber(L, arg)),
+            static_cast<float>(luaL_checknumber(L, arg + 1)),
+            static_cast<float>(luaL_checknumber(L, arg + 2))
+        };
+
+        return arg + 3;
+    }
+}
+
+LuaAdapterCFunction gVec3Natives[] = {
+    {"Vec3", createVec3},
+    {"vecDistanceMatrix", vecDistanceMatrix},
+    {"playerDistanceMatrix", playerDistanceMatrix},
+    {"vecNormalizeArray", vecNormalizeArray},
+    {"vecDotArray", vecDotArray},
+    {"vecCrossArray", vecCrossArray},
+    {nullptr, nullptr}
+};
@@ -0,0 +1,48 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "CommonNatives.hpp"
+
+#include <array>
+
+namespace Luna
+{
+    /*
+     * Vec3 userdata. Arithmetic metamethods return new vectors, the
+     * add/sub/scale/normalize methods modify the vector in place and return it.
+     * Array kernels copy vectors into columns first and never load from here.
+     */
+    struct Vec3
+    {
+        float x;
+        float y;
+        float z;
+    };
+
+    Vec3 *pushVec3(lua_State *L, const std::array<float, 3> &value);
+    Vec3 *toVec3(lua_State *L, int arg);
+    Vec3 *checkVec3(lua_State *L, int arg);
+
+    // Reads either a Vec3 or three numbers starting at arg, returns the index of the next argument
+    int getVec3Args(lua_State *L, int arg, std::array<float, 3> &out);
+}
+
+extern LuaAdapterCFunction gVec3Natives[];
@@ -0,0 +1,159 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "VecMath.hpp"
+
+#include <cmath>
+
+#if defined(LUNA_VECMATH_SSE2)
+    #include <emmintrin.h>
+#endif
+
+namespace Luna::VecMath
+{
+    void distanceMatrix(const float *xs, const float *ys, const float *zs, std::size_t count, float *out)
+    {
+        for (std::size_t i = 0; i < count; i++)
+        {
+            float *row = out + i * count;
+            std::size_t j = 0;
+
+#if defined(LUNA_VECMATH_SSE2)
+            const __m128 x = _mm_set1_ps(xs[i]);
+            const __m128 y = _mm_set1_ps(ys[i]);
+            const __m128 z = _mm_set1_ps(zs[i]);
+
+            for (; j + 4 <= count; j += 4)
+            {
+                __m128 dx = _mm_sub_ps(_mm_loadu_ps(xs + j), x);
+                __m128 dy = _mm_sub_ps(_mm_loadu_ps(ys + j), y);
+                __m128 dz = _mm_sub_ps(_mm_loadu_ps(zs + j), z);
+
+                __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+                _mm_storeu_ps(row + j, _mm_sqrt_ps(sum));
+            }
+#endif
+
+            for (; j < count; j++)
+            {
+                float dx = xs[j] - xs[i];
+                float dy = ys[j] - ys[i];
+                float dz = zs[j] - zs[i];
+
+                row[j] = std::sqrt(dx * dx + dy * dy + dz * dz);
+            }
+        }
+    }
+
+    void normalize(float *xs, float *ys, float *zs, std::size_t count)
+    {
+        std::size_t i = 0;
+
+#if defined(LUNA_VECMATH_SSE2)
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 one = _mm_set1_ps(1.0f);
+
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 x = _mm_loadu_ps(xs + i);
+            __m128 y = _mm_loadu_ps(ys + i);
+            __m128 z = _mm_loadu_ps(zs + i);
+
+            __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+
+            // Lanes with zero length get a scale of 1 so they stay zero instead of turning into NaN
+            __m128 isZero = _mm_cmpeq_ps(length, zero);
+            __m128 scale = _mm_div_ps(one, _mm_or_ps(_mm_and_ps(isZero, one), _mm_andnot_ps(isZero, length)));
+
+            _mm_storeu_ps(xs + i, _mm_mul_ps(x, scale));
+            _mm_storeu_ps(ys + i, _mm_mul_ps(y, scale));
+            _mm_storeu_ps(zs + i, _mm_mul_ps(z, scale));
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            float length = std::sqrt(xs[i] * xs[i] + ys[i] * ys[i] + zs[i] * zs[i]);
+
+            if (length > 0.0f)
+            {
+                xs[i] /= length;
+                ys[i] /= length;
+                zs[i] /= length;
+            }
+        }
+    }
+
+    void dot(const float *ax, const float *ay, const float *az,
+             const float *bx, const float *by, const float *bz,
+             std::size_t count, float *out)
+    {
+        std::size_t i = 0;
+
+#if defined(LUNA_VECMATH_SSE2)
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 x = _mm_mul_ps(_mm_loadu_ps(ax + i), _mm_loadu_ps(bx + i));
+            __m128 y = _mm_mul_ps(_mm_loadu_ps(ay + i), _mm_loadu_ps(by + i));
+            __m128 z = _mm_mul_ps(_mm_loadu_ps(az + i), _mm_loadu_ps(bz + i));
+
+            _mm_storeu_ps(out + i, _mm_add_ps(_mm_add_ps(x, y), z));
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            out[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+        }
+    }
+
+    void cross(const float *ax, const float *ay, const float *az,
+               const float *bx, const float *by, const float *bz,
+               std::size_t count, float *outX, float *outY, float *outZ)
+    {
+        std::size_t i = 0;
+
+#if defined(LUNA_VECMATH_SSE2)
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 x1 = _mm_loadu_ps(ax + i);
+            __m128 y1 = _mm_loadu_ps(ay + i);
+            __m128 z1 = _mm_loadu_ps(az + i);
+            __m128 x2 = _mm_loadu_ps(bx + i);
+            __m128 y2 = _mm_loadu_ps(by + i);
+            __m128 z2 = _mm_loadu_ps(bz + i);
+
+            _mm_storeu_ps(outX + i, _mm_sub_ps(_mm_mul_ps(y1, z2), _mm_mul_ps(z1, y2)));
+            _mm_storeu_ps(outY + i, _mm_sub_ps(_mm_mul_ps(z1, x2), _mm_mul_ps(x1, z2)));
+            _mm_storeu_ps(outZ + i, _mm_sub_ps(_mm_mul_ps(x1, y2), _mm_mul_ps(y1, x2)));
+        }
+#endif
+
+        for (; i < count; i++)
+        {
+            float x = ay[i] * bz[i] - az[i] * by[i];
+            float y = az[i] * bx[i] - ax[i] * bz[i];
+            float z = ax[i] * by[i] - ay[i] * bx[i];
+
+            outX[i] = x;
+            outY[i] = y;
+            outZ[i] = z;
+        }
+    }
+}
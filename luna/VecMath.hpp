@@ -0,0 +1,47 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #define LUNA_VECMATH_SSE2
+#endif
+
+/*
+ * Batch vector kernels over structure-of-arrays input.
+ * Compiled with SSE2 when the target supports it, scalar otherwise.
+ */
+namespace Luna::VecMath
+{
+    // out[i * count + j] = |p[i] - p[j]|
+    void distanceMatrix(const float *xs, const float *ys, const float *zs, std::size_t count, float *out);
+
+    // Zero length vectors are left untouched
+    void normalize(float *xs, float *ys, float *zs, std::size_t count);
+
+    void dot(const float *ax, const float *ay, const float *az,
+             const float *bx, const float *by, const float *bz,
+             std::size_t count, float *out);
+
+    void cross(const float *ax, const float *ay, const float *az,
+               const float *bx, const float *by, const float *bz,
+               std::size_t count, float *outX, float *outY, float *outZ);
+}
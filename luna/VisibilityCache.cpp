@@ -0,0 +1,114 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "VisibilityCache.hpp"
+#include "TracePool.hpp"
+#include "AnubisExports.hpp"
+
+#include <engine/IEdict.hpp>
+
+namespace
+{
+    std::array<float, 3> getEyePosition(nstd::observer_ptr<Anubis::Engine::IEdict> edict)
+    {
+        using Anubis::Engine::IEdict;
+
+        std::array<float, 3> origin = edict->getVecProperty(IEdict::VecProperty::Origin);
+        std::array<float, 3> viewOfs = edict->getVecProperty(IEdict::VecProperty::ViewingOffset);
+
+        return {origin[0] + viewOfs[0], origin[1] + viewOfs[1], origin[2] + viewOfs[2]};
+    }
+}
+
+namespace Luna
+{
+    void VisibilityCache::reset()
+    {
+        m_computed.fill(0);
+    }
+
+    bool VisibilityCache::isVisible(std::uint32_t first, std::uint32_t second)
+    {
+        if (first == second)
+        {
+            return true;
+        }
+
+        std::uint32_t row = first - 1;
+        std::uint32_t column = second - 1;
+        std::uint32_t bit = 1u << column;
+
+        if (m_computed[row] & bit)
+        {
+            m_hits++;
+            return (m_visible[row] & bit) != 0;
+        }
+
+        bool visible = _trace(first, second);
+        m_traces++;
+
+        // Line of sight is symmetric, fill both halves of the matrix
+        std::uint32_t mirrorBit = 1u << row;
+
+        m_computed[row] |= bit;
+        m_computed[column] |= mirrorBit;
+
+        if (visible)
+        {
+            m_visible[row] |= bit;
+            m_visible[column] |= mirrorBit;
+        }
+        else
+        {
+            m_visible[row] &= ~bit;
+            m_visible[column] &= ~mirrorBit;
+        }
+
+        return visible;
+    }
+
+    bool VisibilityCache::_trace(std::uint32_t first, std::uint32_t second) const
+    {
+        nstd::observer_ptr<Anubis::Engine::IEdict> from = gEngine->getEdict(first, Anubis::FuncCallType::Direct);
+        nstd::observer_ptr<Anubis::Engine::IEdict> to = gEngine->getEdict(second, Anubis::FuncCallType::Direct);
+
+        if (!from || !to || from->isFree() || to->isFree())
+        {
+            return false;
+        }
+
+        TracePool::Lease tr = gTracePool->acquire();
+        gEngine->traceLine(getEyePosition(from), getEyePosition(to), Anubis::Engine::TraceMonsters::IgnoreGlassNo,
+                           from, tr.get(), Anubis::FuncCallType::Direct);
+
+        return tr->getFraction() >= 1.0f;
+    }
+
+    std::uint64_t VisibilityCache::getHits() const
+    {
+        return m_hits;
+    }
+
+    std::uint64_t VisibilityCache::getTraces() const
+    {
+        return m_traces;
+    }
+}
+
+std::unique_ptr<Luna::VisibilityCache> gVisibilityCache;
@@ -0,0 +1,59 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+
+namespace Luna
+{
+    /**
+     * @brief Player to player line of sight, traced at most once per pair per frame.
+     *
+     * Pairs are traced lazily on the first query and stored in a symmetric
+     * 32x32 bit matrix, which is reset at the start of every server frame.
+     */
+    class VisibilityCache
+    {
+    public:
+        static constexpr std::uint32_t MAX_PLAYERS = 32;
+
+    public:
+        void reset();
+
+        [[nodiscard]] bool isVisible(std::uint32_t first, std::uint32_t second);
+
+        [[nodiscard]] std::uint64_t getHits() const;
+        [[nodiscard]] std::uint64_t getTraces() const;
+
+    private:
+        [[nodiscard]] bool _trace(std::uint32_t first, std::uint32_t second) const;
+
+    private:
+        // Row i, bit j describes players i + 1 and j + 1
+        std::array<std::uint32_t, MAX_PLAYERS> m_computed{};
+        std::array<std::uint32_t, MAX_PLAYERS> m_visible{};
+        std::uint64_t m_hits{};
+        std::uint64_t m_traces{};
+    };
+}
+
+extern std::unique_ptr<Luna::VisibilityCache> gVisibilityCache;
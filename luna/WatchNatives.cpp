@@ -0,0 +1,55 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WatchNatives.hpp"
+#include "EntityHandle.hpp"
+#include "WatchSystem.hpp"
+
+#include <engine/IEdict.hpp>
+
+// watchProperty(edict, kind, property, callback), kind: 0 float, 1 int, 2 vector, 3 flags
+static int watchProperty(lua_State *L)
+{
+    using Luna::PropertyWatcher;
+
+    auto edict = Luna::checkEdict(L, 1);
+    auto kind = luaL_checkinteger(L, 2);
+    auto property = luaL_checkinteger(L, 3);
+    const char *callback = luaL_checkstring(L, 4);
+
+    luaL_argcheck(L, kind >= 0 && kind <= static_cast<lua_Integer>(PropertyWatcher::Kind::Flags), 2,
+                  "invalid property kind");
+    luaL_argcheck(L, property >= 0 && property <= UINT8_MAX, 3, "invalid property");
+
+    lua_pushinteger(L, gPropertyWatcher->watch(L, edict->getIndex(), static_cast<PropertyWatcher::Kind>(kind),
+                                               static_cast<std::uint8_t>(property), callback));
+    return 1;
+}
+
+static int unwatchProperty(lua_State *L)
+{
+    gPropertyWatcher->unwatch(L, static_cast<Luna::PropertyWatcher::ID>(luaL_checkinteger(L, 1)));
+    return 0;
+}
+
+LuaAdapterCFunction gWatchNatives[] = {
+    {"watchProperty", watchProperty},
+    {"unwatchProperty", unwatchProperty},
+    {nullptr, nullptr}
+};
@@ -0,0 +1,224 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "WatchSystem.hpp"
+#include "EntityHandle.hpp"
+#include "Vec3Natives.hpp"
+#include "AnubisExports.hpp"
+
+#include <engine/IEdict.hpp>
+
+#include <algorithm>
+
+namespace Luna
+{
+    bool PropertyWatcher::Value::operator!=(const Value &other) const
+    {
+        return vec != other.vec || integer != other.integer;
+    }
+
+    PropertyWatcher::ID PropertyWatcher::watch(lua_State *L, std::uint32_t index, Kind kind, std::uint8_t property,
+                                               std::string_view callback)
+    {
+        nstd::observer_ptr<Anubis::Engine::IEdict> edict = gEngine->getEdict(index, Anubis::FuncCallType::Direct);
+
+        // Callbacks run on the main thread, the coroutine calling this may be gone by then
+        Watch watch {m_nextId++, static_cast<std::uint16_t>(index), kind, property, edict->getSerialNumber(),
+                     _findGroup(getMainThread(L), callback), {}};
+
+        std::ignore = _read(watch, watch.value);
+        m_watches.push_back(watch);
+
+        return watch.id;
+    }
+
+    void PropertyWatcher::unwatch(lua_State *L, ID id)
+    {
+        lua_State *owner = getMainThread(L);
+        auto iter = std::find_if(m_watches.begin(), m_watches.end(),
+                                 [this, id, owner](const Watch &watch)
+                                 {
+                                     return watch.id == id && m_groups[watch.group].L == owner;
+                                 });
+
+        if (iter == m_watches.end())
+        {
+            return;
+        }
+
+        *iter = m_watches.back();
+        m_watches.pop_back();
+    }
+
+    void PropertyWatcher::unwatchAll(lua_State *L)
+    {
+        m_watches.erase(std::remove_if(m_watches.begin(), m_watches.end(),
+                                       [this, L](const Watch &watch)
+                                       {
+                                           return m_groups[watch.group].L == L;
+                                       }),
+                        m_watches.end());
+
+        for (auto &group : m_groups)
+        {
+            if (group.L == L)
+            {
+                group.L = nullptr;
+                group.changes.clear();
+            }
+        }
+    }
+
+    void PropertyWatcher::update()
+    {
+        for (std::size_t i = 0; i < m_watches.size();)
+        {
+            Watch &watch = m_watches[i];
+            Value value {};
+
+            if (!_read(watch, value))
+            {
+                // Entity is gone, drop the watch
+                m_watches[i] = m_watches.back();
+                m_watches.pop_back();
+                continue;
+            }
+
+            if (value != watch.value)
+            {
+                m_groups[watch.group].changes.push_back({watch.index, watch.kind, watch.serialNumber, watch.value});
+                watch.value = value;
+            }
+
+            i++;
+        }
+
+        // Callbacks may add watches and groups, so index instead of iterating
+        for (std::size_t i = 0; i < m_groups.size(); i++)
+        {
+            if (m_groups[i].changes.empty() || !m_groups[i].L)
+            {
+                continue;
+            }
+
+            m_dispatching.swap(m_groups[i].changes);
+
+            lua_State *L = m_groups[i].L;
+            std::string callback = m_groups[i].callback;
+            _dispatch(L, callback, m_dispatching);
+
+            m_dispatching.clear();
+        }
+    }
+
+    bool PropertyWatcher::_read(const Watch &watch, Value &out)
+    {
+        using Anubis::Engine::IEdict;
+
+        nstd::observer_ptr<IEdict> edict = gEngine->getEdict(watch.index, Anubis::FuncCallType::Direct);
+
+        if (!edict || edict->isFree() || edict->getSerialNumber() != watch.serialNumber)
+        {
+            return false;
+        }
+
+        switch (watch.kind)
+        {
+            case Kind::Float:
+                out.vec[0] = edict->getFlProperty(static_cast<IEdict::FlProperty>(watch.property));
+                break;
+            case Kind::Int:
+                out.integer = edict->getIntProperty(static_cast<IEdict::IntProperty>(watch.property));
+                break;
+            case Kind::Vec:
+                out.vec = edict->getVecProperty(static_cast<IEdict::VecProperty>(watch.property));
+                break;
+            case Kind::Flags:
+                out.integer = static_cast<std::int32_t>(edict->getFlags());
+                break;
+        }
+
+        return true;
+    }
+
+    std::uint32_t PropertyWatcher::_findGroup(lua_State *L, std::string_view callback)
+    {
+        auto iter = std::find_if(m_groups.begin(), m_groups.end(),
+                                 [L, callback](const Group &group)
+                                 {
+                                     return group.L == L && group.callback == callback;
+                                 });
+
+        if (iter != m_groups.end())
+        {
+            return static_cast<std::uint32_t>(iter - m_groups.begin());
+        }
+
+        m_groups.push_back({L, std::string {callback}, {}});
+        return static_cast<std::uint32_t>(m_groups.size() - 1);
+    }
+
+    // Calls callback(entities, oldValues, count) with every entity whose watched value changed this frame
+    void PropertyWatcher::_dispatch(lua_State *L, const std::string &callback, const std::vector<Change> &changes)
+    {
+        if (lua_getglobal(L, callback.c_str()) == LUA_TNIL)
+        {
+            lua_pop(L, 1);
+            return;
+        }
+
+        auto count = static_cast<int>(changes.size());
+
+        lua_createtable(L, count, 0);
+        lua_createtable(L, count, 0);
+
+        for (int i = 0; i < count; i++)
+        {
+            const Change &change = changes[static_cast<std::size_t>(i)];
+
+            lua_pushinteger(L, makeEdictHandle(change.index, change.serialNumber));
+            lua_rawseti(L, -3, i + 1);
+
+            switch (change.kind)
+            {
+                case Kind::Float:
+                    lua_pushnumber(L, change.old.vec[0]);
+                    break;
+                case Kind::Vec:
+                    pushVec3(L, change.old.vec);
+                    break;
+                case Kind::Int:
+                case Kind::Flags:
+                    lua_pushinteger(L, change.old.integer);
+                    break;
+            }
+
+            lua_rawseti(L, -2, i + 1);
+        }
+
+        lua_pushinteger(L, count);
+
+        if (lua_pcall(L, 3, 0, 0) != LUA_OK)
+        {
+            lua_pop(L, 1);
+        }
+    }
+}
+
+std::unique_ptr<Luna::PropertyWatcher> gPropertyWatcher;
@@ -0,0 +1,108 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "CommonNatives.hpp"
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Luna
+{
+    /**
+     * @brief Per-frame diffing of watched entity properties.
+     *
+     * Previous values are kept in a flat array and compared once per frame.
+     * Changes are grouped by plugin and callback, so each callback runs at most
+     * once per frame with every entity that changed. Watches on freed entities
+     * are dropped during the pass.
+     */
+    class PropertyWatcher
+    {
+    public:
+        enum class Kind : std::uint8_t
+        {
+            Float = 0,
+            Int,
+            Vec,
+            Flags
+        };
+
+        using ID = std::uint32_t;
+
+    public:
+        ID watch(lua_State *L, std::uint32_t index, Kind kind, std::uint8_t property, std::string_view callback);
+        // Only watches of the calling plugin are removed
+        void unwatch(lua_State *L, ID id);
+        void unwatchAll(lua_State *L);
+        void update();
+
+    private:
+        struct Value
+        {
+            std::array<float, 3> vec;
+            std::int32_t integer;
+
+            bool operator!=(const Value &other) const;
+        };
+
+        struct Watch
+        {
+            ID id;
+            std::uint16_t index;
+            Kind kind;
+            std::uint8_t property;
+            std::uint32_t serialNumber;
+            std::uint32_t group;
+            Value value;
+        };
+
+        struct Change
+        {
+            std::uint16_t index;
+            Kind kind;
+            std::uint32_t serialNumber;
+            Value old;
+        };
+
+        struct Group
+        {
+            lua_State *L;
+            std::string callback;
+            std::vector<Change> changes;
+        };
+
+    private:
+        [[nodiscard]] static bool _read(const Watch &watch, Value &out);
+        std::uint32_t _findGroup(lua_State *L, std::string_view callback);
+        static void _dispatch(lua_State *L, const std::string &callback, const std::vector<Change> &changes);
+
+    private:
+        std::vector<Watch> m_watches;
+        std::vector<Group> m_groups;
+        std::vector<Change> m_dispatching;
+        ID m_nextId = 1;
+    };
+}
+
+extern std::unique_ptr<Luna::PropertyWatcher> gPropertyWatcher;
@@ -0,0 +1,236 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "AsyncDispatcher.hpp"
+#include "Natives.hpp"
+#include "Value.hpp"
+
+#include <mariadbsql/IDriver.hpp>
+
+#include <algorithm>
+
+namespace Luna
+{
+    SQLDispatcher::SQLDispatcher(std::size_t workers, std::size_t maxPerFrame)
+        : m_workers(workers),
+          m_maxPerFrame(maxPerFrame)
+    {
+    }
+
+    SQLDispatcher::JobId SQLDispatcher::submit(lua_State *L, MDBSQL::IConnection &connection, Kind kind,
+                                               std::string_view sql, std::vector<MDBSQL::Value> &&params,
+                                               std::string_view callback)
+    {
+        nstd::observer_ptr<MDBSQL::IAsyncExecutor> executor = _getExecutor();
+        if (!executor)
+        {
+            return 0;
+        }
+
+        JobId id = executor->submit(connection, kind, sql, std::move(params));
+        // The callback runs on the main thread, a coroutine may be dead or suspended by then
+        m_pending.try_emplace(id, Pending {getMainThread(L), kind, std::string {callback}, {}});
+
+        return id;
+    }
+
+    SQLDispatcher::JobId SQLDispatcher::submitBatch(MDBSQL::IConnection &connection, std::string_view sql,
+                                                    std::vector<MDBSQL::Value> &&values, std::size_t columns,
+                                                    Handler &&handler)
+    {
+        nstd::observer_ptr<MDBSQL::IAsyncExecutor> executor = _getExecutor();
+        if (!executor)
+        {
+            return 0;
+        }
+
+        JobId id = executor->submitBatch(connection, sql, std::move(values), columns);
+        m_pending.try_emplace(id, Pending {nullptr, Kind::Batch, {}, std::move(handler)});
+
+        return id;
+    }
+
+    std::unique_ptr<MDBSQL::ICursor> SQLDispatcher::openCursor(MDBSQL::IConnection &connection, std::string_view sql,
+                                                               std::vector<MDBSQL::Value> &&params,
+                                                               std::size_t fetchSize, std::size_t maxBuffered)
+    {
+        nstd::observer_ptr<MDBSQL::IAsyncExecutor> executor = _getExecutor();
+        if (!executor)
+        {
+            return nullptr;
+        }
+
+        return executor->openCursor(connection, sql, std::move(params), fetchSize, maxBuffered);
+    }
+
+    void SQLDispatcher::release(MDBSQL::IConnection &connection)
+    {
+        if (m_executor)
+        {
+            m_executor->release(connection);
+        }
+    }
+
+    void SQLDispatcher::drain(MDBSQL::IConnection &connection)
+    {
+        if (m_executor)
+        {
+            m_executor->drain(connection);
+        }
+    }
+
+    bool SQLDispatcher::isBusy(MDBSQL::IConnection &connection) const
+    {
+        return m_executor && m_executor->isBusy(connection);
+    }
+
+    void SQLDispatcher::dispatch()
+    {
+        m_lastFrame = 0;
+
+        if (!m_executor)
+        {
+            return;
+        }
+
+        m_lastFrame = m_executor->poll(m_completions, m_maxPerFrame);
+
+        for (const auto &completion : m_completions)
+        {
+            auto iter = m_pending.find(completion.id);
+
+            // Plugin was unloaded in the meantime
+            if (iter == m_pending.end())
+            {
+                continue;
+            }
+
+            Pending pending = std::move(iter->second);
+            m_pending.erase(iter);
+
+            if (pending.handler)
+            {
+                pending.handler(completion);
+                continue;
+            }
+
+            _call(pending, completion);
+        }
+
+        m_completions.clear();
+    }
+
+    void SQLDispatcher::cancel(lua_State *L)
+    {
+        for (auto it = m_pending.begin(); it != m_pending.end();)
+        {
+            if (it->second.L == L)
+            {
+                it = m_pending.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    void SQLDispatcher::shutdown()
+    {
+        if (m_executor)
+        {
+            m_executor->stop();
+        }
+
+        m_pending.clear();
+    }
+
+    SQLDispatcher::Stats SQLDispatcher::getStats() const
+    {
+        Stats stats {};
+
+        if (m_executor)
+        {
+            stats.executor = m_executor->getStats();
+        }
+
+        stats.pending = m_pending.size();
+        stats.lastFrame = m_lastFrame;
+
+        return stats;
+    }
+
+    nstd::observer_ptr<MDBSQL::IAsyncExecutor> SQLDispatcher::_getExecutor()
+    {
+        if (m_executor)
+        {
+            return m_executor;
+        }
+
+        nstd::observer_ptr<MDBSQL::IDriver> driver = findSQLDriver();
+        if (!driver)
+        {
+            return nullptr;
+        }
+
+        m_executor = &driver->getAsyncExecutor();
+        m_executor->start(m_workers);
+
+        return m_executor;
+    }
+
+    // Calls callback(success, rows or affected rows, error)
+    void SQLDispatcher::_call(const Pending &pending, const MDBSQL::IAsyncExecutor::Completion &completion)
+    {
+        lua_State *L = pending.L;
+
+        if (lua_getglobal(L, pending.callback.c_str()) == LUA_TNIL)
+        {
+            lua_pop(L, 1);
+            return;
+        }
+
+        lua_pushboolean(L, completion.success);
+
+        if (!completion.success)
+        {
+            lua_pushnil(L);
+            lua_pushlstring(L, completion.error.data(), completion.error.length());
+        }
+        else
+        {
+            if (pending.kind == Kind::Query)
+            {
+                pushSQLRows(L, completion.rows);
+            }
+            else
+            {
+                lua_pushinteger(L, static_cast<lua_Integer>(completion.updateCount));
+            }
+
+            lua_pushnil(L);
+        }
+
+        if (lua_pcall(L, 3, 0, 0) != LUA_OK)
+        {
+            lua_pop(L, 1);
+        }
+    }
+}
+
+std::unique_ptr<Luna::SQLDispatcher> gSQLDispatcher;
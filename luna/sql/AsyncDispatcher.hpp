@@ -0,0 +1,101 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "../CommonNatives.hpp"
+
+#include <mariadbsql/IAsyncExecutor.hpp>
+
+#include <observer_ptr.hpp>
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace Luna
+{
+    /**
+     * @brief Hands SQL queries to the extension's worker pool and runs their callbacks.
+     *
+     * Completions are drained in ServerFrame, at most a configured number per
+     * frame, so a burst of finished queries is spread over several frames.
+     */
+    class SQLDispatcher
+    {
+    public:
+        using JobId = MDBSQL::IAsyncExecutor::JobId;
+        using Kind = MDBSQL::IAsyncExecutor::Kind;
+        using Completion = MDBSQL::IAsyncExecutor::Completion;
+        using Handler = std::function<void(const Completion &)>;
+
+        struct Stats
+        {
+            MDBSQL::IAsyncExecutor::Stats executor;
+            std::size_t pending;
+            std::size_t lastFrame;
+        };
+
+    public:
+        SQLDispatcher(std::size_t workers, std::size_t maxPerFrame);
+
+        [[nodiscard]] JobId submit(lua_State *L, MDBSQL::IConnection &connection, Kind kind, std::string_view sql,
+                                   std::vector<MDBSQL::Value> &&params, std::string_view callback);
+        // Completion goes to a native handler instead of a plugin callback
+        [[nodiscard]] JobId submitBatch(MDBSQL::IConnection &connection, std::string_view sql,
+                                        std::vector<MDBSQL::Value> &&values, std::size_t columns, Handler &&handler);
+        // Rows are taken from the cursor by the caller, there is no completion to dispatch
+        [[nodiscard]] std::unique_ptr<MDBSQL::ICursor> openCursor(MDBSQL::IConnection &connection, std::string_view sql,
+                                                                  std::vector<MDBSQL::Value> &&params,
+                                                                  std::size_t fetchSize, std::size_t maxBuffered);
+        void release(MDBSQL::IConnection &connection);
+        void drain(MDBSQL::IConnection &connection);
+        [[nodiscard]] bool isBusy(MDBSQL::IConnection &connection) const;
+        void dispatch();
+        void cancel(lua_State *L);
+        void shutdown();
+
+        [[nodiscard]] Stats getStats() const;
+
+    private:
+        struct Pending
+        {
+            lua_State *L;
+            Kind kind;
+            std::string callback;
+            Handler handler;
+        };
+
+    private:
+        [[nodiscard]] nstd::observer_ptr<MDBSQL::IAsyncExecutor> _getExecutor();
+        static void _call(const Pending &pending, const MDBSQL::IAsyncExecutor::Completion &completion);
+
+    private:
+        std::unordered_map<JobId, Pending> m_pending;
+        std::vector<MDBSQL::IAsyncExecutor::Completion> m_completions;
+        nstd::observer_ptr<MDBSQL::IAsyncExecutor> m_executor;
+        std::size_t m_workers;
+        std::size_t m_maxPerFrame;
+        std::size_t m_lastFrame{};
+    };
+}
+
+extern std::unique_ptr<Luna::SQLDispatcher> gSQLDispatcher;
@@ -0,0 +1,238 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "Handles.hpp"
+#include "Natives.hpp"
+#include "AsyncDispatcher.hpp"
+#include "WriteBehind.hpp"
+#include "../AnubisExports.hpp"
+
+#include <fmt/format.h>
+
+namespace Luna
+{
+    void SQLHandles::pushConnection(lua_State *L, std::unique_ptr<MDBSQL::IConnection> &&connection)
+    {
+        _pushHandle(L, m_connections.add(_getOwner(L), 0, std::move(connection)), CONNECTION_META, nullptr);
+    }
+
+    void SQLHandles::pushStatement(lua_State *L, std::unique_ptr<MDBSQL::IStatement> &&statement, int connectionArg)
+    {
+        const Handle *connection = _toHandle(L, connectionArg, CONNECTION_META);
+
+        _pushHandle(L, m_statements.add(_getOwner(L), connection ? *connection : 0, std::move(statement)),
+                    STATEMENT_META, _collectStatement);
+    }
+
+    void SQLHandles::pushCursor(lua_State *L, std::unique_ptr<MDBSQL::ICursor> &&cursor, int connectionArg)
+    {
+        const Handle *connection = _toHandle(L, connectionArg, CONNECTION_META);
+
+        _pushHandle(L, m_cursors.add(_getOwner(L), connection ? *connection : 0, std::move(cursor)), CURSOR_META,
+                    _collectCursor);
+    }
+
+    void SQLHandles::pushResultSet(lua_State *L, std::unique_ptr<MDBSQL::IResultSet> &&resultSet, int statementArg)
+    {
+        statementArg = lua_absindex(L, statementArg);
+
+        const Handle *statement = _toHandle(L, statementArg, STATEMENT_META);
+        Handle connection = statement ? m_statements.getParent(*statement) : 0;
+
+        _pushHandle(L, m_resultSets.add(_getOwner(L), connection, std::move(resultSet)), RESULT_SET_META,
+                    _collectResultSet);
+
+        // Result sets are finalized before their statement as long as the statement is referenced here
+        lua_pushvalue(L, statementArg);
+        lua_setiuservalue(L, -2, 1);
+    }
+
+    MDBSQL::IConnection *SQLHandles::toConnection(lua_State *L, int arg) const
+    {
+        const Handle *handle = _toHandle(L, arg, CONNECTION_META);
+
+        return handle ? m_connections.get(*handle) : nullptr;
+    }
+
+    MDBSQL::IStatement *SQLHandles::toStatement(lua_State *L, int arg) const
+    {
+        const Handle *handle = _toHandle(L, arg, STATEMENT_META);
+
+        return handle ? m_statements.get(*handle) : nullptr;
+    }
+
+    MDBSQL::IResultSet *SQLHandles::toResultSet(lua_State *L, int arg) const
+    {
+        const Handle *handle = _toHandle(L, arg, RESULT_SET_META);
+
+        return handle ? m_resultSets.get(*handle) : nullptr;
+    }
+
+    MDBSQL::ICursor *SQLHandles::toCursor(lua_State *L, int arg) const
+    {
+        const Handle *handle = _toHandle(L, arg, CURSOR_META);
+
+        return handle ? m_cursors.get(*handle) : nullptr;
+    }
+
+    MDBSQL::IConnection *SQLHandles::getStatementConnection(lua_State *L, int arg) const
+    {
+        const Handle *handle = _toHandle(L, arg, STATEMENT_META);
+
+        return handle ? m_connections.get(m_statements.getParent(*handle)) : nullptr;
+    }
+
+    // Explicitly destroyed handles are zeroed so the finalizer never touches a reused slot
+    void SQLHandles::disconnect(lua_State *L, int arg)
+    {
+        if (Handle *handle = _toHandle(L, arg, CONNECTION_META); handle)
+        {
+            if (std::unique_ptr<MDBSQL::IConnection> connection = m_connections.remove(_getOwner(L), *handle);
+                connection)
+            {
+                _close(*handle, std::move(connection));
+            }
+
+            *handle = 0;
+        }
+    }
+
+    void SQLHandles::destroyStatement(lua_State *L, int arg)
+    {
+        if (Handle *handle = _toHandle(L, arg, STATEMENT_META); handle)
+        {
+            m_statements.remove(_getOwner(L), *handle);
+            *handle = 0;
+        }
+    }
+
+    void SQLHandles::destroyResultSet(lua_State *L, int arg)
+    {
+        if (Handle *handle = _toHandle(L, arg, RESULT_SET_META); handle)
+        {
+            m_resultSets.remove(_getOwner(L), *handle);
+            *handle = 0;
+        }
+    }
+
+    void SQLHandles::closeCursor(lua_State *L, int arg)
+    {
+        if (Handle *handle = _toHandle(L, arg, CURSOR_META); handle)
+        {
+            m_cursors.remove(_getOwner(L), *handle);
+            *handle = 0;
+        }
+    }
+
+    void SQLHandles::drop(lua_State *L, std::string_view pluginName)
+    {
+        lua_State *owner = _getOwner(L);
+
+        // Release in dependency order, result sets before their statements before their connections.
+        // Closing cursors first also frees the workers streaming into them.
+        std::size_t cursors = m_cursors.removeOwned(owner).size();
+        std::size_t resultSets = m_resultSets.removeOwned(owner).size();
+        std::size_t statements = m_statements.removeOwned(owner).size();
+        std::size_t connections = 0;
+
+        for (auto &connection : m_connections.removeOwned(owner))
+        {
+            // Children were released above already
+            _close(0, std::move(connection));
+            connections++;
+        }
+
+        if (!cursors && !resultSets && !statements && !connections)
+        {
+            return;
+        }
+
+        std::string warn =
+            fmt::format("Plugin {} leaked {} SQL connections, {} statements, {} result sets and {} cursors.",
+                        pluginName, connections, statements, resultSets, cursors);
+        gLogger->logMsg(Anubis::LogDest::ConsoleFile, Anubis::LogLevel::Warning, warn);
+    }
+
+    SQLHandles::Stats SQLHandles::getStats() const
+    {
+        return {m_connections.size(), m_statements.size(), m_resultSets.size(), m_cursors.size()};
+    }
+
+    lua_State *SQLHandles::_getOwner(lua_State *L)
+    {
+        // Handles created in coroutines belong to the plugin's main state
+        return getMainThread(L);
+    }
+
+    void SQLHandles::_pushHandle(lua_State *L, Handle handle, const char *metaName, lua_CFunction gc)
+    {
+        *static_cast<Handle *>(lua_newuserdatauv(L, sizeof(Handle), 1)) = handle;
+
+        if (luaL_newmetatable(L, metaName) && gc)
+        {
+            lua_pushcfunction(L, gc);
+            lua_setfield(L, -2, "__gc");
+        }
+
+        lua_setmetatable(L, -2);
+    }
+
+    SQLHandles::Handle *SQLHandles::_toHandle(lua_State *L, int arg, const char *metaName)
+    {
+        return static_cast<Handle *>(luaL_testudata(L, arg, metaName));
+    }
+
+    void SQLHandles::_close(Handle handle, std::unique_ptr<MDBSQL::IConnection> &&connection)
+    {
+        // Objects created from the connection must not outlive it, result sets go before their statements
+        if (handle)
+        {
+            m_cursors.removeChildren(handle);
+            m_resultSets.removeChildren(handle);
+            m_statements.removeChildren(handle);
+        }
+
+        removeSQLGroupCommit(*connection);
+        gSQLWriteBehind->release(*connection);
+        gSQLDispatcher->release(*connection);
+    }
+
+    // Handles that were destroyed explicitly are zeroed by now and ignored
+    int SQLHandles::_collectStatement(lua_State *L)
+    {
+        gSQLHandles->destroyStatement(L, 1);
+
+        return 0;
+    }
+
+    int SQLHandles::_collectResultSet(lua_State *L)
+    {
+        gSQLHandles->destroyResultSet(L, 1);
+
+        return 0;
+    }
+
+    int SQLHandles::_collectCursor(lua_State *L)
+    {
+        gSQLHandles->closeCursor(L, 1);
+
+        return 0;
+    }
+}
+
+std::unique_ptr<Luna::SQLHandles> gSQLHandles;
@@ -0,0 +1,256 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "../CommonNatives.hpp"
+
+#include <cinttypes>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include <mariadbsql/IConnection.hpp>
+#include <mariadbsql/IStatement.hpp>
+#include <mariadbsql/IResultSet.hpp>
+#include <mariadbsql/ICursor.hpp>
+
+namespace Luna
+{
+    /**
+     * @brief Slab of objects addressed by generational handles.
+     *
+     * A handle packs the slot index with the slot's generation. The generation
+     * is bumped whenever the slot is freed so stale handles fail validation
+     * without a search. It is wide enough that it never wraps in practice.
+     */
+    template<typename t_object>
+    class HandleSlab
+    {
+    public:
+        using Handle = std::uint64_t;
+
+    public:
+        // parent is the handle of the object this one depends on, 0 for none
+        Handle add(lua_State *owner, Handle parent, std::unique_ptr<t_object> &&object)
+        {
+            std::uint32_t index;
+
+            if (!m_free.empty())
+            {
+                index = m_free.back();
+                m_free.pop_back();
+            }
+            else
+            {
+                index = static_cast<std::uint32_t>(m_slots.size());
+                m_slots.emplace_back();
+            }
+
+            Slot &slot = m_slots[index];
+            slot.object = std::move(object);
+            slot.owner = owner;
+            slot.parent = parent;
+
+            m_used++;
+
+            return (slot.generation << INDEX_BITS) | index;
+        }
+
+        [[nodiscard]] t_object *get(Handle handle) const
+        {
+            const Slot *slot = _find(handle);
+
+            return slot ? slot->object.get() : nullptr;
+        }
+
+        [[nodiscard]] Handle getParent(Handle handle) const
+        {
+            const Slot *slot = _find(handle);
+
+            return slot ? slot->parent : 0;
+        }
+
+        // Only the plugin owning the object may free it
+        std::unique_ptr<t_object> remove(lua_State *owner, Handle handle)
+        {
+            const Slot *slot = _find(handle);
+
+            if (!slot || slot->owner != owner)
+            {
+                return nullptr;
+            }
+
+            return _free(static_cast<std::uint32_t>(handle & INDEX_MASK));
+        }
+
+        std::vector<std::unique_ptr<t_object>> removeOwned(lua_State *owner)
+        {
+            return _removeIf(
+                [owner](const Slot &slot)
+                {
+                    return slot.owner == owner;
+                });
+        }
+
+        std::vector<std::unique_ptr<t_object>> removeChildren(Handle parent)
+        {
+            return _removeIf(
+                [parent](const Slot &slot)
+                {
+                    return slot.parent == parent;
+                });
+        }
+
+        [[nodiscard]] std::size_t size() const
+        {
+            return m_used;
+        }
+
+    private:
+        static constexpr Handle INDEX_BITS = 20;
+        static constexpr Handle INDEX_MASK = (Handle(1) << INDEX_BITS) - 1;
+
+        struct Slot
+        {
+            std::unique_ptr<t_object> object;
+            lua_State *owner = nullptr;
+            Handle parent = 0;
+            // Starts at 1 so a zeroed handle is never valid
+            Handle generation = 1;
+        };
+
+    private:
+        [[nodiscard]] const Slot *_find(Handle handle) const
+        {
+            auto index = static_cast<std::size_t>(handle & INDEX_MASK);
+
+            if (index >= m_slots.size() || m_slots[index].generation != handle >> INDEX_BITS ||
+                !m_slots[index].object)
+            {
+                return nullptr;
+            }
+
+            return &m_slots[index];
+        }
+
+        template<typename t_pred>
+        std::vector<std::unique_ptr<t_object>> _removeIf(t_pred &&pred)
+        {
+            std::vector<std::unique_ptr<t_object>> objects;
+
+            for (std::uint32_t index = 0; index < m_slots.size(); index++)
+            {
+                if (m_slots[index].object && pred(m_slots[index]))
+                {
+                    objects.push_back(_free(index));
+                }
+            }
+
+            return objects;
+        }
+
+        std::unique_ptr<t_object> _free(std::uint32_t index)
+        {
+            Slot &slot = m_slots[index];
+
+            slot.generation++;
+            slot.owner = nullptr;
+            slot.parent = 0;
+            m_free.push_back(index);
+            m_used--;
+
+            return std::move(slot.object);
+        }
+
+    private:
+        std::vector<Slot> m_slots;
+        std::vector<std::uint32_t> m_free;
+        std::size_t m_used{};
+    };
+
+    /**
+     * @brief SQL objects handed out to plugins.
+     *
+     * Objects reach Lua as full userdata holding a handle and are owned by the
+     * plugin that created them. Statements, result sets and cursors are released
+     * by the Lua GC when a plugin forgets to destroy them. Connections are not, queued
+     * async queries and write-behind buffers still refer to them. Disconnecting
+     * releases the statements and result sets of the connection first. Whatever
+     * is left when a plugin is unloaded is reported and released.
+     */
+    class SQLHandles
+    {
+    public:
+        struct Stats
+        {
+            std::size_t connections;
+            std::size_t statements;
+            std::size_t resultSets;
+            std::size_t cursors;
+        };
+
+    public:
+        void pushConnection(lua_State *L, std::unique_ptr<MDBSQL::IConnection> &&connection);
+        // Objects created from the connection at connectionArg
+        void pushStatement(lua_State *L, std::unique_ptr<MDBSQL::IStatement> &&statement, int connectionArg);
+        void pushCursor(lua_State *L, std::unique_ptr<MDBSQL::ICursor> &&cursor, int connectionArg);
+        // Result set keeps the statement at statementArg alive until it is collected
+        void pushResultSet(lua_State *L, std::unique_ptr<MDBSQL::IResultSet> &&resultSet, int statementArg);
+
+        [[nodiscard]] MDBSQL::IConnection *toConnection(lua_State *L, int arg) const;
+        [[nodiscard]] MDBSQL::IStatement *toStatement(lua_State *L, int arg) const;
+        [[nodiscard]] MDBSQL::IResultSet *toResultSet(lua_State *L, int arg) const;
+        [[nodiscard]] MDBSQL::ICursor *toCursor(lua_State *L, int arg) const;
+        // Connection the statement at arg was created from
+        [[nodiscard]] MDBSQL::IConnection *getStatementConnection(lua_State *L, int arg) const;
+
+        void disconnect(lua_State *L, int arg);
+        void destroyStatement(lua_State *L, int arg);
+        void destroyResultSet(lua_State *L, int arg);
+        void closeCursor(lua_State *L, int arg);
+        void drop(lua_State *L, std::string_view pluginName);
+
+        [[nodiscard]] Stats getStats() const;
+
+    private:
+        using Handle = std::uint64_t;
+
+        static constexpr const char *CONNECTION_META = "Luna.SQLConnection";
+        static constexpr const char *STATEMENT_META = "Luna.SQLStatement";
+        static constexpr const char *RESULT_SET_META = "Luna.SQLResultSet";
+        static constexpr const char *CURSOR_META = "Luna.SQLCursor";
+
+    private:
+        static lua_State *_getOwner(lua_State *L);
+        static void _pushHandle(lua_State *L, Handle handle, const char *metaName, lua_CFunction gc);
+        [[nodiscard]] static Handle *_toHandle(lua_State *L, int arg, const char *metaName);
+        void _close(Handle handle, std::unique_ptr<MDBSQL::IConnection> &&connection);
+        static int _collectStatement(lua_State *L);
+        static int _collectResultSet(lua_State *L);
+        static int _collectCursor(lua_State *L);
+
+    private:
+        HandleSlab<MDBSQL::IConnection> m_connections;
+        HandleSlab<MDBSQL::IStatement> m_statements;
+        HandleSlab<MDBSQL::IResultSet> m_resultSets;
+        HandleSlab<MDBSQL::ICursor> m_cursors;
+    };
+}
+
+extern std::unique_ptr<Luna::SQLHandles> gSQLHandles;
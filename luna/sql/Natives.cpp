@@ -18,7 +18,15 @@
  */
 
 #include "Natives.hpp"
+#include "AsyncDispatcher.hpp"
+#include "WriteBehind.hpp"
+#include "Handles.hpp"
+#include "Value.hpp"
 #include "../ExtSystem.hpp"
+#include "../ConfigSystem.hpp"
+#include "../AnubisExports.hpp"
+
+#include <fmt/format.h>
 
 #include <vector>
 #include <cstddef>
@@ -29,23 +37,87 @@
 #include <mariadbsql/IResultSet.hpp>
 #include <mariadbsql/IPreparedStatement.hpp>
 
-std::vector<std::unique_ptr<Luna::MDBSQL::IConnection>> gConnections;
-std::vector<std::unique_ptr<Luna::MDBSQL::IStatement>> gStatements;
-std::vector<std::unique_ptr<Luna::MDBSQL::IResultSet>> gResultSets;
+std::vector<Luna::MDBSQL::IConnection *> gGroupCommitConnections;
 
-static int getDriver(lua_State *L)
+nstd::observer_ptr<Luna::MDBSQL::IDriver> findSQLDriver()
 {
     auto itExt = std::find_if(gExtList.begin(), gExtList.end(), [](const Luna::Extension &ext) {
         return ext.getName() == "MariaDB Extension";
     });
 
     if (itExt == gExtList.end())
+    {
+        return nullptr;
+    }
+
+    return std::any_cast<nstd::observer_ptr<Luna::MDBSQL::IDriver>>(itExt->getImpl());
+}
+
+void initSQLDriver()
+{
+    nstd::observer_ptr<Luna::MDBSQL::IDriver> driver = findSQLDriver();
+
+    if (!driver)
+    {
+        return;
+    }
+
+    // Pooled connections are opened with the cache size already set
+    driver->setStatementCacheSize(gConfig->getSQLStatementCacheSize());
+
+    for (const auto &pool : gConfig->getSQLPools())
+    {
+        Luna::MDBSQL::PoolConfig config;
+        config.url = pool.url;
+        config.properties = {{"user", pool.user}, {"password", pool.password}};
+        config.minSize = pool.minSize;
+        config.maxSize = pool.maxSize;
+        config.idleTimeout = pool.idleTimeout;
+
+        driver->createPool(pool.name, config);
+    }
+}
+
+void removeSQLGroupCommit(const Luna::MDBSQL::IConnection &connection)
+{
+    gGroupCommitConnections.erase(
+        std::remove(gGroupCommitConnections.begin(), gGroupCommitConnections.end(), &connection),
+        gGroupCommitConnections.end());
+}
+
+void flushSQLGroupCommits()
+{
+    for (Luna::MDBSQL::IConnection *connection : gGroupCommitConnections)
+    {
+        // A worker may be running a batch inside the group, it is committed on a later frame
+        if (gSQLDispatcher->isBusy(*connection))
+        {
+            continue;
+        }
+
+        try
+        {
+            connection->flushGroupCommit(false);
+        }
+        catch (const std::exception &e)
+        {
+            std::string warn = fmt::format("Group commit failed: {}", e.what());
+            gLogger->logMsg(Anubis::LogDest::ConsoleFile, Anubis::LogLevel::Warning, warn);
+        }
+    }
+}
+
+static int getDriver(lua_State *L)
+{
+    nstd::observer_ptr<Luna::MDBSQL::IDriver> driver = findSQLDriver();
+
+    if (!driver)
     {
         lua_pushnil(L);
     }
     else
     {
-        lua_pushlightuserdata(L, std::any_cast<nstd::observer_ptr<Luna::MDBSQL::IDriver>>(itExt->getImpl()).get());
+        lua_pushlightuserdata(L, driver.get());
     }
 
     return 1;
@@ -68,9 +140,7 @@ static int connect(lua_State *L)
 
         if (auto connection = driver->connect(host, user, pwd); connection)
         {
-            auto &con = gConnections.emplace_back(std::move(connection));
-
-            lua_pushlightuserdata(L, con.get());
+            gSQLHandles->pushConnection(L, std::move(connection));
         }
         else
         {
@@ -81,22 +151,74 @@ static int connect(lua_State *L)
     return 1;
 }
 
-static int disconnect(lua_State *L)
+static int connectPool(lua_State *L)
 {
-    auto conn = reinterpret_cast<Luna::MDBSQL::IConnection *>(lua_touserdata(L, 1));
+    auto driver = reinterpret_cast<Luna::MDBSQL::IDriver *>(lua_touserdata(L, 1));
 
-    if (conn)
+    if (!driver)
     {
-        auto it = std::find_if(gConnections.begin(), gConnections.end(), [conn](const std::unique_ptr<Luna::MDBSQL::IConnection> &_conn) {
-            return conn == _conn.get();
-        });
+        lua_pushnil(L);
+        return 1;
+    }
 
-        if (it != gConnections.end())
-        {
-            gConnections.erase(it);
-        }
+    const char *name = luaL_checkstring(L, 2);
+
+    // Disconnecting a leased connection hands it back to the pool
+    if (auto connection = driver->acquire(name); connection)
+    {
+        gSQLHandles->pushConnection(L, std::move(connection));
+    }
+    else
+    {
+        lua_pushnil(L);
     }
 
+    return 1;
+}
+
+static int getPoolStats(lua_State *L)
+{
+    auto driver = reinterpret_cast<Luna::MDBSQL::IDriver *>(lua_touserdata(L, 1));
+
+    if (!driver)
+    {
+        return 0;
+    }
+
+    Luna::MDBSQL::PoolStats stats = driver->getPoolStats(luaL_checkstring(L, 2));
+
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.idle));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.leased));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.created));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.reused));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.discarded));
+
+    return 5;
+}
+
+static int getStatementCacheStats(lua_State *L)
+{
+    auto conn = gSQLHandles->toConnection(L, 1);
+
+    if (!conn)
+    {
+        return 0;
+    }
+
+    Luna::MDBSQL::StatementCacheStats stats = conn->getStatementCacheStats();
+
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.size));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.hits));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.misses));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.evictions));
+
+    return 4;
+}
+
+static int disconnect(lua_State *L)
+{
+    gSQLHandles->disconnect(L, 1);
+
     return 0;
 }
 
@@ -134,9 +256,18 @@ static int getDriverName(lua_State *L)
     return 1;
 }
 
+// Worker threads use the connection while it has async jobs or an open cursor
+static void checkConnectionIdle(lua_State *L, Luna::MDBSQL::IConnection *conn)
+{
+    if (conn && gSQLDispatcher->isBusy(*conn))
+    {
+        luaL_error(L, "connection is in use by an async query or cursor");
+    }
+}
+
 static int createStatementInternal(lua_State *L, bool prepared)
 {
-    auto conn = reinterpret_cast<Luna::MDBSQL::IConnection *>(lua_touserdata(L, 1));
+    auto conn = gSQLHandles->toConnection(L, 1);
 
     if (!conn)
     {
@@ -144,6 +275,8 @@ static int createStatementInternal(lua_State *L, bool prepared)
     }
     else
     {
+        checkConnectionIdle(L, conn);
+
         const char *sql;
         if (prepared)
         {
@@ -153,8 +286,7 @@ static int createStatementInternal(lua_State *L, bool prepared)
 
         if (auto statement = (!prepared) ? conn->createStatement() : conn->prepareStatement(sql); statement)
         {
-            auto &stmt = gStatements.emplace_back(std::move(statement));
-            lua_pushlightuserdata(L, stmt.get());
+            gSQLHandles->pushStatement(L, std::move(statement), 1);
         }
         else
         {
@@ -172,26 +304,14 @@ static int createStatement(lua_State *L)
 
 static int destroyStatement(lua_State *L)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
-
-    if (stmt)
-    {
-        auto it = std::find_if(gStatements.begin(), gStatements.end(), [stmt](const std::unique_ptr<Luna::MDBSQL::IStatement> &_stmt) {
-               return stmt == _stmt.get();
-        });
-
-        if (it != gStatements.end())
-        {
-            gStatements.erase(it);
-        }
-    }
+    gSQLHandles->destroyStatement(L, 1);
 
     return 0;
 }
 
 static int executeStatement(lua_State *L)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
+    auto stmt = gSQLHandles->toStatement(L, 1);
 
     if (!stmt)
     {
@@ -199,6 +319,8 @@ static int executeStatement(lua_State *L)
     }
     else
     {
+        checkConnectionIdle(L, gSQLHandles->getStatementConnection(L, 1));
+
         const char *sql = nullptr;
         Luna::MDBSQL::IPreparedStatement *pStmt = nullptr;
         if (lua_gettop(L) == 2)
@@ -219,7 +341,7 @@ static int executeStatement(lua_State *L)
 
 static int executeQueryStatement(lua_State *L)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
+    auto stmt = gSQLHandles->toStatement(L, 1);
 
     if (!stmt)
     {
@@ -227,6 +349,8 @@ static int executeQueryStatement(lua_State *L)
     }
     else
     {
+        checkConnectionIdle(L, gSQLHandles->getStatementConnection(L, 1));
+
         const char *sql = nullptr;
         Luna::MDBSQL::IPreparedStatement *pStmt = nullptr;
         if (lua_gettop(L) == 2)
@@ -242,8 +366,7 @@ static int executeQueryStatement(lua_State *L)
 
         if (auto resultSet = (sql ? stmt->executeQuery(sql) : pStmt->executeQuery()); resultSet)
         {
-            auto &result = gResultSets.emplace_back(std::move(resultSet));
-            lua_pushlightuserdata(L, result.get());
+            gSQLHandles->pushResultSet(L, std::move(resultSet), 1);
         }
         else
         {
@@ -256,7 +379,7 @@ static int executeQueryStatement(lua_State *L)
 
 static int executeUpdateStatementInternal(lua_State *L, bool large)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
+    auto stmt = gSQLHandles->toStatement(L, 1);
 
     if (!stmt)
     {
@@ -264,6 +387,8 @@ static int executeUpdateStatementInternal(lua_State *L, bool large)
     }
     else
     {
+        checkConnectionIdle(L, gSQLHandles->getStatementConnection(L, 1));
+
         const char *sql = nullptr;
         Luna::MDBSQL::IPreparedStatement *pStmt = nullptr;
         if (lua_gettop(L) == 2)
@@ -302,7 +427,7 @@ static int executeUpdateLargeStatement(lua_State *L)
 
 static int statementClose(lua_State *L)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
+    auto stmt = gSQLHandles->toStatement(L, 1);
 
     if (stmt)
     {
@@ -314,7 +439,7 @@ static int statementClose(lua_State *L)
 
 static int statementIsClosed(lua_State *L)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
+    auto stmt = gSQLHandles->toStatement(L, 1);
 
     if (stmt)
     {
@@ -351,7 +476,7 @@ enum class TypePStmt : std::uint8_t
 
 static int preparedStatementInternal(lua_State *L, TypePStmt type)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
+    auto stmt = gSQLHandles->toStatement(L, 1);
     Luna::MDBSQL::IPreparedStatement *pStmt;
     try
     {
@@ -488,9 +613,138 @@ static int preparedStatementBigInt(lua_State *L)
     return preparedStatementInternal(L, TypePStmt::BigInt);
 }
 
+static const char *toColumnTypeName(Luna::MDBSQL::ColumnType type)
+{
+    switch (type)
+    {
+        case Luna::MDBSQL::ColumnType::Null:
+            return "null";
+        case Luna::MDBSQL::ColumnType::Bool:
+            return "bool";
+        case Luna::MDBSQL::ColumnType::Integer:
+            return "integer";
+        case Luna::MDBSQL::ColumnType::Float:
+            return "float";
+        case Luna::MDBSQL::ColumnType::String:
+            return "string";
+    }
+
+    return "string";
+}
+
+static Luna::MDBSQL::ColumnType toColumnType(std::string_view name)
+{
+    if (name == "bool")
+    {
+        return Luna::MDBSQL::ColumnType::Bool;
+    }
+
+    if (name == "integer")
+    {
+        return Luna::MDBSQL::ColumnType::Integer;
+    }
+
+    if (name == "float")
+    {
+        return Luna::MDBSQL::ColumnType::Float;
+    }
+
+    if (name == "null")
+    {
+        return Luna::MDBSQL::ColumnType::Null;
+    }
+
+    return Luna::MDBSQL::ColumnType::String;
+}
+
+// Executes rows of parameters as one batch: (stmt, rows [, rewrite [, types]])
+static int preparedStatementExecuteBatch(lua_State *L)
+{
+    auto pStmt = dynamic_cast<Luna::MDBSQL::IPreparedStatement *>(
+        gSQLHandles->toStatement(L, 1));
+
+    if (!pStmt)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    checkConnectionIdle(L, gSQLHandles->getStatementConnection(L, 1));
+    luaL_checktype(L, 2, LUA_TTABLE);
+    bool rewrite = lua_toboolean(L, 3);
+
+    // Declared types fix the column count, otherwise it is taken from the first row
+    std::vector<Luna::MDBSQL::ColumnType> types;
+    if (!lua_isnoneornil(L, 4))
+    {
+        luaL_checktype(L, 4, LUA_TTABLE);
+        auto count = static_cast<lua_Integer>(lua_rawlen(L, 4));
+
+        for (lua_Integer i = 1; i <= count; i++)
+        {
+            lua_rawgeti(L, 4, i);
+            types.push_back(toColumnType(luaL_checkstring(L, -1)));
+            lua_pop(L, 1);
+        }
+    }
+
+    auto rows = static_cast<lua_Integer>(lua_rawlen(L, 2));
+    std::size_t columns = types.size();
+
+    if (!columns && rows)
+    {
+        lua_rawgeti(L, 2, 1);
+        luaL_checktype(L, -1, LUA_TTABLE);
+        columns = lua_rawlen(L, -1);
+        lua_pop(L, 1);
+    }
+
+    if (!columns)
+    {
+        lua_pushinteger(L, 0);
+        return 1;
+    }
+
+    std::vector<Luna::MDBSQL::Value> values;
+    values.reserve(static_cast<std::size_t>(rows) * columns);
+
+    for (lua_Integer row = 1; row <= rows; row++)
+    {
+        if (lua_rawgeti(L, 2, row) != LUA_TTABLE)
+        {
+            return luaL_error(L, "row %d is not a table", static_cast<int>(row));
+        }
+
+        for (std::size_t column = 1; column <= columns; column++)
+        {
+            lua_rawgeti(L, -1, static_cast<lua_Integer>(column));
+
+            Luna::MDBSQL::Value &value = values.emplace_back();
+            if (!Luna::toSQLValue(L, -1, value))
+            {
+                return luaL_error(L, "unsupported type of value %d in row %d", static_cast<int>(column),
+                                  static_cast<int>(row));
+            }
+
+            if (!types.empty() && !Luna::coerceSQLValue(value, types[column - 1]))
+            {
+                return luaL_error(L, "value %d in row %d does not fit its column type", static_cast<int>(column),
+                                  static_cast<int>(row));
+            }
+
+            lua_pop(L, 1);
+        }
+
+        lua_pop(L, 1);
+    }
+
+    lua_pushinteger(L, static_cast<lua_Integer>(pStmt->executeBatch(values, columns, rewrite)));
+    return 1;
+}
+
 static int escapeProcessing(lua_State *L)
 {
-    auto stmt = reinterpret_cast<Luna::MDBSQL::IStatement *>(lua_touserdata(L, 1));
+    auto stmt = gSQLHandles->toStatement(L, 1);
 
     if (stmt)
     {
@@ -502,7 +756,7 @@ static int escapeProcessing(lua_State *L)
 
 static int resultSetNext(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
 
     if (rs)
     {
@@ -518,7 +772,7 @@ static int resultSetNext(lua_State *L)
 
 static int isFirstInternal(lua_State *L, bool before)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
 
     if (rs)
     {
@@ -544,7 +798,7 @@ static int resultSetIsBeforeFirst(lua_State *L)
 
 static int isLastInternal(lua_State *L, bool after)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
 
     if (rs)
     {
@@ -570,7 +824,7 @@ static int resultSetIsAfterLast(lua_State *L)
 
 static int resultSetBeforeFirst(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         rs->beforeFirst();
@@ -581,7 +835,7 @@ static int resultSetBeforeFirst(lua_State *L)
 
 static int resultSetAfterLast(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         rs->afterLast();
@@ -592,7 +846,7 @@ static int resultSetAfterLast(lua_State *L)
 
 static int resultSetFirst(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         lua_pushboolean(L, rs->first());
@@ -607,7 +861,7 @@ static int resultSetFirst(lua_State *L)
 
 static int resultSetLast(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         lua_pushboolean(L, rs->last());
@@ -622,7 +876,7 @@ static int resultSetLast(lua_State *L)
 
 static int resultSetGetRow(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         lua_pushinteger(L, rs->getRow());
@@ -637,7 +891,7 @@ static int resultSetGetRow(lua_State *L)
 
 static int resultSetPrevious(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         lua_pushboolean(L, rs->previous());
@@ -652,7 +906,7 @@ static int resultSetPrevious(lua_State *L)
 
 static int resultSetGetFetchDirection(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         lua_pushnumber(L, rs->getFetchDirection());
@@ -667,7 +921,7 @@ static int resultSetGetFetchDirection(lua_State *L)
 
 static int resultSetSetFetchDirection(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         rs->setFetchDirection(static_cast<Luna::MDBSQL::IResultSet::FetchDirection>(lua_tonumber(L, 2)));
@@ -678,7 +932,7 @@ static int resultSetSetFetchDirection(lua_State *L)
 
 static int resultSetGet(lua_State *L, TypePStmt type, bool name)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         std::int32_t pos;
@@ -759,9 +1013,79 @@ static int resultSetGet(lua_State *L, TypePStmt type, bool name)
     return 1;
 }
 
+// Returns labels and types as two arrays, array index + 1 is the column index for *ById getters
+static int resultSetGetColumns(lua_State *L)
+{
+    auto rs = gSQLHandles->toResultSet(L, 1);
+
+    if (!rs)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    const std::vector<std::string> &names = rs->getColumnNames();
+    const std::vector<Luna::MDBSQL::ColumnType> &types = rs->getColumnTypes();
+
+    lua_createtable(L, static_cast<int>(names.size()), 0);
+    for (std::size_t i = 0; i < names.size(); i++)
+    {
+        lua_pushlstring(L, names[i].data(), names[i].length());
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+
+    lua_createtable(L, static_cast<int>(types.size()), 0);
+    for (std::size_t i = 0; i < types.size(); i++)
+    {
+        lua_pushstring(L, toColumnTypeName(types[i]));
+        lua_rawseti(L, -2, static_cast<lua_Integer>(i + 1));
+    }
+
+    return 2;
+}
+
+static int resultSetFetchInternal(lua_State *L, std::size_t max, int columnarArg)
+{
+    auto rs = gSQLHandles->toResultSet(L, 1);
+
+    if (!rs)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    Luna::MDBSQL::Rows rows;
+    std::size_t count = rs->fetch(rows, max);
+
+    if (lua_toboolean(L, columnarArg))
+    {
+        Luna::pushSQLColumns(L, rows);
+    }
+    else
+    {
+        Luna::pushSQLRows(L, rows);
+    }
+
+    lua_pushinteger(L, static_cast<lua_Integer>(count));
+    return 2;
+}
+
+static int resultSetFetchAll(lua_State *L)
+{
+    return resultSetFetchInternal(L, 0, 2);
+}
+
+static int resultSetFetchMany(lua_State *L)
+{
+    lua_Integer max = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, max > 0, 2, "count must be positive");
+
+    return resultSetFetchInternal(L, static_cast<std::size_t>(max), 3);
+}
+
 static int resultSetFindColumn(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    auto rs = gSQLHandles->toResultSet(L, 1);
     if (rs)
     {
         size_t length;
@@ -884,23 +1208,486 @@ static int SQLResultSetGetShortByName(lua_State *L)
 
 static int resultSetDestroy(lua_State *L)
 {
-    auto rs = reinterpret_cast<Luna::MDBSQL::IResultSet *>(lua_touserdata(L, 1));
+    gSQLHandles->destroyResultSet(L, 1);
 
-    if (rs)
+    return 0;
+}
+
+static int executeAsyncInternal(lua_State *L, Luna::SQLDispatcher::Kind kind)
+{
+    auto conn = gSQLHandles->toConnection(L, 1);
+
+    if (!conn)
     {
-        auto it = std::find_if(gResultSets.begin(), gResultSets.end(), [rs](const std::unique_ptr<Luna::MDBSQL::IResultSet> &_rs) {
-                                   return rs == _rs.get();
-                               });
+        lua_pushnil(L);
+        return 1;
+    }
 
-        if (it != gResultSets.end())
+    size_t length;
+    const char *sql = luaL_checklstring(L, 2, &length);
+    std::vector<Luna::MDBSQL::Value> params = Luna::checkSQLParams(L, 3);
+    const char *callback = luaL_checkstring(L, 4);
+
+    if (auto id = gSQLDispatcher->submit(L, *conn, kind, {sql, length}, std::move(params), callback); id)
+    {
+        lua_pushinteger(L, static_cast<lua_Integer>(id));
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+
+    return 1;
+}
+
+// SQLExecuteQueryAsync(conn, sql, params, callback), callback(success, rows, error) runs in a later frame
+static int executeQueryAsync(lua_State *L)
+{
+    return executeAsyncInternal(L, Luna::SQLDispatcher::Kind::Query);
+}
+
+// SQLExecuteUpdateAsync(conn, sql, params, callback), callback(success, affectedRows, error) runs in a later frame
+static int executeUpdateAsync(lua_State *L)
+{
+    return executeAsyncInternal(L, Luna::SQLDispatcher::Kind::Update);
+}
+
+// SQLOpenCursor(conn, sql [, params [, fetchSize [, maxBuffered]]]), rows are streamed by a worker while the
+// connection stays busy, so give long scans a connection of their own
+static int openCursor(lua_State *L)
+{
+    auto conn = gSQLHandles->toConnection(L, 1);
+
+    if (!conn)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    size_t length;
+    const char *sql = luaL_checklstring(L, 2, &length);
+    std::vector<Luna::MDBSQL::Value> params = Luna::checkSQLParams(L, 3);
+    lua_Integer fetchSize = luaL_optinteger(L, 4, static_cast<lua_Integer>(gConfig->getSQLCursorFetchSize()));
+    lua_Integer maxBuffered = luaL_optinteger(L, 5, static_cast<lua_Integer>(gConfig->getSQLCursorMaxBuffered()));
+
+    luaL_argcheck(L, fetchSize > 0, 4, "fetch size must be positive");
+    luaL_argcheck(L, maxBuffered > 0, 5, "buffer size must be positive");
+
+    if (auto cursor = gSQLDispatcher->openCursor(*conn, {sql, length}, std::move(params),
+                                                 static_cast<std::size_t>(fetchSize),
+                                                 static_cast<std::size_t>(maxBuffered));
+        cursor)
+    {
+        gSQLHandles->pushCursor(L, std::move(cursor), 1);
+    }
+    else
+    {
+        lua_pushnil(L);
+    }
+
+    return 1;
+}
+
+// Pushes nil and the error, if there was one, once the cursor has nothing more to give
+static int pushCursorEnd(lua_State *L, const Luna::MDBSQL::ICursor &cursor)
+{
+    lua_pushnil(L);
+
+    if (std::string error = cursor.getError(); !error.empty())
+    {
+        lua_pushlstring(L, error.data(), error.length());
+        return 2;
+    }
+
+    return 1;
+}
+
+// SQLCursorFetch(cursor, count [, columnar]) never waits, the table is empty while the worker is behind
+static int cursorFetch(lua_State *L)
+{
+    auto cursor = gSQLHandles->toCursor(L, 1);
+
+    if (!cursor)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    lua_Integer max = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, max > 0, 2, "count must be positive");
+
+    if (cursor->isDone())
+    {
+        return pushCursorEnd(L, *cursor);
+    }
+
+    Luna::MDBSQL::Rows rows;
+    std::size_t count = cursor->take(rows, static_cast<std::size_t>(max));
+
+    if (lua_toboolean(L, 3))
+    {
+        Luna::pushSQLColumns(L, rows);
+    }
+    else
+    {
+        Luna::pushSQLRows(L, rows);
+    }
+
+    lua_pushinteger(L, static_cast<lua_Integer>(count));
+    return 2;
+}
+
+static int cursorIterate(lua_State *L)
+{
+    lua_Integer index = lua_tointeger(L, lua_upvalueindex(2)) + 1;
+
+    if (lua_rawgeti(L, lua_upvalueindex(1), index) != LUA_TNIL)
+    {
+        lua_pushinteger(L, index);
+        lua_replace(L, lua_upvalueindex(2));
+    }
+
+    return 1;
+}
+
+// for row in SQLCursorRows(cursor, count) do ... end, visits at most count of the rows buffered so far
+static int cursorRows(lua_State *L)
+{
+    auto cursor = gSQLHandles->toCursor(L, 1);
+    lua_Integer max = luaL_checkinteger(L, 2);
+    luaL_argcheck(L, max > 0, 2, "count must be positive");
+
+    Luna::MDBSQL::Rows rows;
+
+    if (cursor)
+    {
+        cursor->take(rows, static_cast<std::size_t>(max));
+    }
+
+    Luna::pushSQLRows(L, rows);
+    lua_pushinteger(L, 0);
+    lua_pushcclosure(L, cursorIterate, 2);
+
+    return 1;
+}
+
+// Returns true and the error, if there was one, once every row was taken
+static int cursorIsDone(lua_State *L)
+{
+    auto cursor = gSQLHandles->toCursor(L, 1);
+
+    if (!cursor)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    if (!cursor->isDone())
+    {
+        lua_pushboolean(L, false);
+        return 1;
+    }
+
+    lua_pushboolean(L, true);
+
+    if (std::string error = cursor->getError(); !error.empty())
+    {
+        lua_pushlstring(L, error.data(), error.length());
+        return 2;
+    }
+
+    return 1;
+}
+
+static int cursorClose(lua_State *L)
+{
+    gSQLHandles->closeCursor(L, 1);
+
+    return 0;
+}
+
+// Returns rows buffered, rows read from the server and rows taken by the plugin
+static int cursorGetStats(lua_State *L)
+{
+    auto cursor = gSQLHandles->toCursor(L, 1);
+
+    if (!cursor)
+    {
+        return 0;
+    }
+
+    Luna::MDBSQL::ICursor::Stats stats = cursor->getStats();
+
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.buffered));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.fetched));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.taken));
+
+    return 3;
+}
+
+// Returns queued, running, finished but not yet dispatched, dispatched last frame and total processed queries
+static int getAsyncStats(lua_State *L)
+{
+    Luna::SQLDispatcher::Stats stats = gSQLDispatcher->getStats();
+
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.executor.queued));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.executor.running));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.executor.completed));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.lastFrame));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.executor.processed));
+    return 5;
+}
+
+// Runs a transaction call and returns true or false with the error message
+template<typename t_func>
+static int transactionCall(lua_State *L, t_func &&func)
+{
+    auto conn = gSQLHandles->toConnection(L, 1);
+
+    if (!conn)
+    {
+        lua_pushboolean(L, false);
+        lua_pushstring(L, "invalid connection");
+        return 2;
+    }
+
+    if (gSQLDispatcher->isBusy(*conn))
+    {
+        lua_pushboolean(L, false);
+        lua_pushstring(L, "connection is in use by an async query or cursor");
+        return 2;
+    }
+
+    try
+    {
+        func(*conn);
+    }
+    catch (const std::exception &e)
+    {
+        lua_pushboolean(L, false);
+        lua_pushstring(L, e.what());
+        return 2;
+    }
+
+    lua_pushboolean(L, true);
+    return 1;
+}
+
+static int setAutoCommit(lua_State *L)
+{
+    bool autoCommit = lua_toboolean(L, 2);
+
+    return transactionCall(L,
+                           [autoCommit](Luna::MDBSQL::IConnection &conn)
+                           {
+                               conn.setAutoCommit(autoCommit);
+                           });
+}
+
+static int beginTransaction(lua_State *L)
+{
+    return transactionCall(L,
+                           [](Luna::MDBSQL::IConnection &conn)
+                           {
+                               conn.begin();
+                           });
+}
+
+static int commitTransaction(lua_State *L)
+{
+    return transactionCall(L,
+                           [](Luna::MDBSQL::IConnection &conn)
+                           {
+                               conn.commit();
+                           });
+}
+
+static int rollbackTransaction(lua_State *L)
+{
+    return transactionCall(L,
+                           [](Luna::MDBSQL::IConnection &conn)
+                           {
+                               conn.rollback();
+                           });
+}
+
+static int setSavepoint(lua_State *L)
+{
+    std::string_view name = luaL_checkstring(L, 2);
+
+    return transactionCall(L,
+                           [name](Luna::MDBSQL::IConnection &conn)
+                           {
+                               conn.setSavepoint(name);
+                           });
+}
+
+static int releaseSavepoint(lua_State *L)
+{
+    std::string_view name = luaL_checkstring(L, 2);
+
+    return transactionCall(L,
+                           [name](Luna::MDBSQL::IConnection &conn)
+                           {
+                               conn.releaseSavepoint(name);
+                           });
+}
+
+static int rollbackToSavepoint(lua_State *L)
+{
+    std::string_view name = luaL_checkstring(L, 2);
+
+    return transactionCall(L,
+                           [name](Luna::MDBSQL::IConnection &conn)
+                           {
+                               conn.rollbackToSavepoint(name);
+                           });
+}
+
+// (conn, enable [, windowMs]), the window defaults to sql.group_commit_window
+static int setGroupCommit(lua_State *L)
+{
+    bool enable = lua_toboolean(L, 2);
+    auto window = static_cast<std::uint32_t>(luaL_optinteger(L, 3, gConfig->getSQLGroupCommitWindow()));
+
+    return transactionCall(L,
+                           [enable, window](Luna::MDBSQL::IConnection &conn)
+                           {
+                               auto it = std::find(gGroupCommitConnections.begin(), gGroupCommitConnections.end(),
+                                                   &conn);
+
+                               conn.setGroupCommit(enable ? window : 0);
+
+                               if (enable && it == gGroupCommitConnections.end())
+                               {
+                                   gGroupCommitConnections.push_back(&conn);
+                               }
+                               else if (!enable && it != gGroupCommitConnections.end())
+                               {
+                                   gGroupCommitConnections.erase(it);
+                               }
+                           });
+}
+
+// Reads the merge mode on top of the stack, nil replaces
+static Luna::SQLWriteBehind::MergeMode checkMergeMode(lua_State *L)
+{
+    if (lua_isnil(L, -1))
+    {
+        return Luna::SQLWriteBehind::MergeMode::Replace;
+    }
+
+    const char *name = lua_tostring(L, -1);
+    std::string_view mode = name ? name : "";
+
+    if (mode == "add")
+    {
+        return Luna::SQLWriteBehind::MergeMode::Add;
+    }
+
+    if (mode != "replace")
+    {
+        const char *given = name ? name : lua_typename(L, lua_type(L, -1));
+        luaL_argerror(L, 4, lua_pushfstring(L, "unknown merge mode '%s'", given));
+    }
+
+    return Luna::SQLWriteBehind::MergeMode::Replace;
+}
+
+// Upsert with the key in the first keyColumns placeholders: (conn, sql, keyColumns [, merge])
+// merge lists "add" or "replace" per column, columns without one are replaced
+static int writeBehindCreate(lua_State *L)
+{
+    auto conn = gSQLHandles->toConnection(L, 1);
+
+    if (!conn)
+    {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    size_t length;
+    const char *sql = luaL_checklstring(L, 2, &length);
+    lua_Integer keyColumns = luaL_checkinteger(L, 3);
+    luaL_argcheck(L, keyColumns > 0, 3, "at least one key column is required");
+
+    std::vector<Luna::SQLWriteBehind::MergeMode> merge;
+    if (!lua_isnoneornil(L, 4))
+    {
+        luaL_checktype(L, 4, LUA_TTABLE);
+        auto count = static_cast<lua_Integer>(lua_rawlen(L, 4));
+
+        for (lua_Integer i = 1; i <= count; i++)
         {
-            gResultSets.erase(it);
+            lua_rawgeti(L, 4, i);
+            merge.push_back(checkMergeMode(L));
+            lua_pop(L, 1);
         }
     }
 
+    Luna::SQLWriteBehind::Id id =
+        gSQLWriteBehind->create(L, *conn, {sql, length}, static_cast<std::size_t>(keyColumns), std::move(merge));
+
+    lua_pushinteger(L, static_cast<lua_Integer>(id));
+    return 1;
+}
+
+static int writeBehindAdd(lua_State *L)
+{
+    auto id = static_cast<Luna::SQLWriteBehind::Id>(luaL_checkinteger(L, 1));
+
+    if (!gSQLWriteBehind->add(L, id, Luna::checkSQLParams(L, 2)))
+    {
+        return luaL_error(L, "invalid write-behind buffer or row size");
+    }
+
+    return 0;
+}
+
+static int writeBehindFlush(lua_State *L)
+{
+    gSQLWriteBehind->flush(L, static_cast<Luna::SQLWriteBehind::Id>(luaL_checkinteger(L, 1)));
+
+    return 0;
+}
+
+static int writeBehindDestroy(lua_State *L)
+{
+    gSQLWriteBehind->destroy(L, static_cast<Luna::SQLWriteBehind::Id>(luaL_checkinteger(L, 1)));
+
     return 0;
 }
 
+// Returns backlog, last flush duration in ms, the coalescing ratio (rows added per row written), flushes, failed
+// flushes and rows dropped after failing too often
+static int getWriteBehindStats(lua_State *L)
+{
+    Luna::SQLWriteBehind::Stats stats = gSQLWriteBehind->getStats();
+
+    std::uint64_t coalesced = stats.written + stats.backlog;
+
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.backlog));
+    lua_pushnumber(L, static_cast<lua_Number>(stats.lastFlushUs) / 1000.0);
+    lua_pushnumber(L, coalesced ? static_cast<lua_Number>(stats.submitted) / static_cast<lua_Number>(coalesced) : 1.0);
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.flushes));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.failures));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.dropped));
+
+    return 6;
+}
+
+static int getHandleStats(lua_State *L)
+{
+    Luna::SQLHandles::Stats stats = gSQLHandles->getStats();
+
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.connections));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.statements));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.resultSets));
+    lua_pushinteger(L, static_cast<lua_Integer>(stats.cursors));
+
+    return 4;
+}
+
 LuaAdapterCFunction gSQLNatives[] = {
     {"getSQLDriver", getDriver},
     {"getSQLDriverName", getDriverName},
@@ -927,6 +1714,7 @@ LuaAdapterCFunction gSQLNatives[] = {
     {"SQLPreparedStatementSetFloat", preparedStatementFloat},
     {"SQLPreparedStatementSetDouble", preparedStatementDouble},
     {"SQLPreparedStatementSetBigInt", preparedStatementBigInt},
+    {"SQLPreparedStatementExecuteBatch", preparedStatementExecuteBatch},
     {"SQLStatementEscapeProcessing", escapeProcessing},
     {"SQLResultSetNext", resultSetNext},
     {"SQLResultSetIsFirst", resultSetIsFirst},
@@ -964,6 +1752,35 @@ LuaAdapterCFunction gSQLNatives[] = {
     {"SQLResultSetIsNullByName", SQLResultSetIsNullByName},
     {"SQLResultSetIsNullById", SQLResultSetIsNullById},
     {"SQLResultSetFindColumn", resultSetFindColumn},
+    {"SQLResultSetFetchAll", resultSetFetchAll},
+    {"SQLResultSetFetchMany", resultSetFetchMany},
+    {"SQLResultSetGetColumns", resultSetGetColumns},
     {"SQLResultSetDestroy", resultSetDestroy},
+    {"SQLExecuteQueryAsync", executeQueryAsync},
+    {"SQLExecuteUpdateAsync", executeUpdateAsync},
+    {"SQLGetAsyncStats", getAsyncStats},
+    {"SQLSetAutoCommit", setAutoCommit},
+    {"SQLBegin", beginTransaction},
+    {"SQLCommit", commitTransaction},
+    {"SQLRollback", rollbackTransaction},
+    {"SQLSetSavepoint", setSavepoint},
+    {"SQLReleaseSavepoint", releaseSavepoint},
+    {"SQLRollbackToSavepoint", rollbackToSavepoint},
+    {"SQLSetGroupCommit", setGroupCommit},
+    {"SQLWriteBehindCreate", writeBehindCreate},
+    {"SQLWriteBehindAdd", writeBehindAdd},
+    {"SQLWriteBehindFlush", writeBehindFlush},
+    {"SQLWriteBehindDestroy", writeBehindDestroy},
+    {"SQLGetWriteBehindStats", getWriteBehindStats},
+    {"SQLConnectPool", connectPool},
+    {"SQLGetPoolStats", getPoolStats},
+    {"SQLGetStatementCacheStats", getStatementCacheStats},
+    {"SQLGetHandleStats", getHandleStats},
+    {"SQLOpenCursor", openCursor},
+    {"SQLCursorFetch", cursorFetch},
+    {"SQLCursorRows", cursorRows},
+    {"SQLCursorIsDone", cursorIsDone},
+    {"SQLCursorClose", cursorClose},
+    {"SQLCursorGetStats", cursorGetStats},
     {nullptr, nullptr},
 };
\ No newline at end of file
@@ -21,4 +21,17 @@
 
 #include "../CommonNatives.hpp"
 
+#include <observer_ptr.hpp>
+
+namespace Luna::MDBSQL
+{
+    class IDriver;
+    class IConnection;
+}
+
+nstd::observer_ptr<Luna::MDBSQL::IDriver> findSQLDriver();
+void initSQLDriver();
+void removeSQLGroupCommit(const Luna::MDBSQL::IConnection &connection);
+void flushSQLGroupCommits();
+
 extern LuaAdapterCFunction gSQLNatives[];
@@ -0,0 +1,238 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "../CommonNatives.hpp"
+
+#include <mariadbsql/Value.hpp>
+
+#include <cstdio>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace Luna
+{
+    inline void pushSQLValue(lua_State *L, const MDBSQL::Value &value)
+    {
+        std::visit(
+            [L](const auto &v)
+            {
+                using T = std::decay_t<decltype(v)>;
+
+                if constexpr (std::is_same_v<T, std::monostate>)
+                {
+                    lua_pushnil(L);
+                }
+                else if constexpr (std::is_same_v<T, bool>)
+                {
+                    lua_pushboolean(L, v);
+                }
+                else if constexpr (std::is_same_v<T, std::int64_t>)
+                {
+                    lua_pushinteger(L, static_cast<lua_Integer>(v));
+                }
+                else if constexpr (std::is_same_v<T, double>)
+                {
+                    lua_pushnumber(L, v);
+                }
+                else
+                {
+                    lua_pushlstring(L, v.data(), v.length());
+                }
+            },
+            value);
+    }
+
+    // Pushes rows as an array of tables keyed by column label
+    inline void pushSQLRows(lua_State *L, const MDBSQL::Rows &rows)
+    {
+        std::size_t columns = rows.columns.size();
+        std::size_t count = rows.getRowCount();
+
+        lua_createtable(L, static_cast<int>(count), 0);
+
+        for (std::size_t row = 0; row < count; row++)
+        {
+            lua_createtable(L, 0, static_cast<int>(columns));
+
+            for (std::size_t column = 0; column < columns; column++)
+            {
+                pushSQLValue(L, rows.values[row * columns + column]);
+                lua_setfield(L, -2, rows.columns[column].c_str());
+            }
+
+            lua_rawseti(L, -2, static_cast<lua_Integer>(row + 1));
+        }
+    }
+
+    // Pushes rows as a table keyed by column label holding one array per column, NULLs leave holes
+    inline void pushSQLColumns(lua_State *L, const MDBSQL::Rows &rows)
+    {
+        std::size_t columns = rows.columns.size();
+        std::size_t count = rows.getRowCount();
+
+        lua_createtable(L, 0, static_cast<int>(columns));
+
+        for (std::size_t column = 0; column < columns; column++)
+        {
+            lua_createtable(L, static_cast<int>(count), 0);
+
+            for (std::size_t row = 0; row < count; row++)
+            {
+                const MDBSQL::Value &value = rows.values[row * columns + column];
+
+                if (std::holds_alternative<std::monostate>(value))
+                {
+                    continue;
+                }
+
+                pushSQLValue(L, value);
+                lua_rawseti(L, -2, static_cast<lua_Integer>(row + 1));
+            }
+
+            lua_setfield(L, -2, rows.columns[column].c_str());
+        }
+    }
+
+    // Converts the value at idx, returns false for types without an SQL counterpart
+    inline bool toSQLValue(lua_State *L, int idx, MDBSQL::Value &value)
+    {
+        switch (lua_type(L, idx))
+        {
+            case LUA_TNIL:
+                value = std::monostate {};
+                return true;
+            case LUA_TBOOLEAN:
+                value = static_cast<bool>(lua_toboolean(L, idx));
+                return true;
+            case LUA_TNUMBER:
+                if (lua_isinteger(L, idx))
+                {
+                    value = static_cast<std::int64_t>(lua_tointeger(L, idx));
+                }
+                else
+                {
+                    value = static_cast<double>(lua_tonumber(L, idx));
+                }
+                return true;
+            case LUA_TSTRING:
+            {
+                size_t length;
+                const char *string = lua_tolstring(L, idx, &length);
+                value = std::string {string, length};
+                return true;
+            }
+            default:
+                return false;
+        }
+    }
+
+    // Converts a value to a declared column type, NULLs are kept. Returns false if the value does not fit the type
+    inline bool coerceSQLValue(MDBSQL::Value &value, MDBSQL::ColumnType type)
+    {
+        if (std::holds_alternative<std::monostate>(value))
+        {
+            return true;
+        }
+
+        switch (type)
+        {
+            case MDBSQL::ColumnType::Null:
+                value = std::monostate {};
+                break;
+            case MDBSQL::ColumnType::Bool:
+                if (auto number = std::get_if<std::int64_t>(&value); number)
+                {
+                    value = *number != 0;
+                }
+                break;
+            case MDBSQL::ColumnType::Integer:
+                if (auto number = std::get_if<double>(&value); number)
+                {
+                    constexpr auto min = static_cast<double>(std::numeric_limits<std::int64_t>::min());
+
+                    // -min is 2^63, one past the largest int64, NaN fails both comparisons
+                    if (!(*number >= min && *number < -min))
+                    {
+                        return false;
+                    }
+
+                    value = static_cast<std::int64_t>(*number);
+                }
+                else if (auto boolean = std::get_if<bool>(&value); boolean)
+                {
+                    value = static_cast<std::int64_t>(*boolean);
+                }
+                break;
+            case MDBSQL::ColumnType::Float:
+                if (auto number = std::get_if<std::int64_t>(&value); number)
+                {
+                    value = static_cast<double>(*number);
+                }
+                break;
+            case MDBSQL::ColumnType::String:
+                if (auto number = std::get_if<std::int64_t>(&value); number)
+                {
+                    value = std::to_string(*number);
+                }
+                else if (auto real = std::get_if<double>(&value); real)
+                {
+                    // Enough digits to round-trip, to_string() uses %f and would cut small values to zero
+                    char buffer[32];
+                    int length = std::snprintf(buffer, sizeof(buffer), "%.17g", *real);
+                    value = std::string {buffer, static_cast<std::size_t>(length)};
+                }
+                break;
+        }
+
+        return true;
+    }
+
+    // Reads an array of query parameters, raises an error on unsupported types
+    inline std::vector<MDBSQL::Value> checkSQLParams(lua_State *L, int arg)
+    {
+        std::vector<MDBSQL::Value> params;
+
+        if (lua_isnoneornil(L, arg))
+        {
+            return params;
+        }
+
+        luaL_checktype(L, arg, LUA_TTABLE);
+        auto count = static_cast<lua_Integer>(lua_rawlen(L, arg));
+
+        params.reserve(static_cast<std::size_t>(count));
+
+        for (lua_Integer i = 1; i <= count; i++)
+        {
+            lua_rawgeti(L, arg, i);
+
+            if (!toSQLValue(L, -1, params.emplace_back()))
+            {
+                luaL_error(L, "unsupported type of parameter %d", static_cast<int>(i));
+            }
+
+            lua_pop(L, 1);
+        }
+
+        return params;
+    }
+}
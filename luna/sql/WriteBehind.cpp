@@ -0,0 +1,370 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "WriteBehind.hpp"
+#include "AsyncDispatcher.hpp"
+#include "../AnubisExports.hpp"
+#include "../CommonNatives.hpp"
+
+#include <mariadbsql/IConnection.hpp>
+
+#include <fmt/format.h>
+
+#include <variant>
+
+namespace Luna
+{
+    std::size_t SQLWriteBehind::KeyHash::operator()(const Key &key) const
+    {
+        std::size_t hash = 0;
+
+        for (const MDBSQL::Value &value : key)
+        {
+            hash ^= std::hash<MDBSQL::Value> {}(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+
+        return hash;
+    }
+
+    SQLWriteBehind::SQLWriteBehind(float flushInterval, std::size_t maxPending)
+        : m_flushInterval(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(flushInterval))),
+          m_maxPending(maxPending)
+    {
+    }
+
+    SQLWriteBehind::Id SQLWriteBehind::create(lua_State *L, MDBSQL::IConnection &connection, std::string_view sql,
+                                              std::size_t keyColumns, std::vector<MergeMode> &&merge)
+    {
+        Id id = m_nextId++;
+
+        m_buffers.try_emplace(id, Buffer {getMainThread(L), &connection, std::string {sql}, keyColumns, 0,
+                                          std::move(merge), {}, {}, Clock::now(), 0});
+
+        return id;
+    }
+
+    bool SQLWriteBehind::add(lua_State *L, Id id, std::vector<MDBSQL::Value> &&row)
+    {
+        Buffer *found = _find(L, id);
+        if (!found)
+        {
+            return false;
+        }
+
+        Buffer &buffer = *found;
+
+        // First row decides the column count
+        if (!buffer.columns)
+        {
+            buffer.columns = row.size();
+        }
+
+        if (row.size() != buffer.columns || row.size() <= buffer.keyColumns)
+        {
+            return false;
+        }
+
+        m_submitted++;
+
+        Key key(row.begin(), row.begin() + static_cast<std::ptrdiff_t>(buffer.keyColumns));
+
+        if (auto existing = buffer.rows.find(key); existing != buffer.rows.end())
+        {
+            MDBSQL::Value *values = buffer.values.data() + existing->second * buffer.columns;
+
+            for (std::size_t i = buffer.keyColumns; i < buffer.columns; i++)
+            {
+                if (i < buffer.merge.size() && buffer.merge[i] == MergeMode::Add)
+                {
+                    _merge(values[i], std::move(row[i]));
+                }
+                else
+                {
+                    values[i] = std::move(row[i]);
+                }
+            }
+
+            return true;
+        }
+
+        buffer.rows.emplace(std::move(key), buffer.rows.size());
+        std::move(row.begin(), row.end(), std::back_inserter(buffer.values));
+
+        if (buffer.rows.size() >= m_maxPending)
+        {
+            _flush(id, buffer);
+        }
+
+        return true;
+    }
+
+    void SQLWriteBehind::flush(lua_State *L, Id id)
+    {
+        if (Buffer *buffer = _find(L, id); buffer)
+        {
+            _flush(id, *buffer);
+        }
+    }
+
+    void SQLWriteBehind::destroy(lua_State *L, Id id)
+    {
+        if (Buffer *buffer = _find(L, id); buffer)
+        {
+            _flush(id, *buffer);
+            m_buffers.erase(id);
+        }
+    }
+
+    void SQLWriteBehind::update()
+    {
+        Clock::time_point now = Clock::now();
+
+        for (auto &[id, buffer] : m_buffers)
+        {
+            if (now - buffer.lastFlush >= m_flushInterval)
+            {
+                _flush(id, buffer);
+            }
+        }
+    }
+
+    void SQLWriteBehind::flushAll()
+    {
+        for (auto &[id, buffer] : m_buffers)
+        {
+            _flush(id, buffer);
+        }
+    }
+
+    void SQLWriteBehind::release(MDBSQL::IConnection &connection)
+    {
+        _removeIf(
+            [&connection](const Buffer &buffer)
+            {
+                return buffer.connection == &connection;
+            });
+    }
+
+    void SQLWriteBehind::drop(lua_State *L)
+    {
+        _removeIf(
+            [L](const Buffer &buffer)
+            {
+                return buffer.L == L;
+            });
+    }
+
+    SQLWriteBehind::Stats SQLWriteBehind::getStats() const
+    {
+        Stats stats {};
+
+        stats.backlog = m_inFlight;
+        for (const auto &[id, buffer] : m_buffers)
+        {
+            stats.backlog += buffer.rows.size();
+        }
+
+        stats.submitted = m_submitted;
+        stats.written = m_written;
+        stats.flushes = m_flushes;
+        stats.failures = m_failures;
+        stats.dropped = m_dropped;
+        stats.lastFlushUs = m_lastFlushUs;
+
+        return stats;
+    }
+
+    SQLWriteBehind::Buffer *SQLWriteBehind::_find(lua_State *L, Id id)
+    {
+        auto it = m_buffers.find(id);
+
+        return it != m_buffers.end() && it->second.L == getMainThread(L) ? &it->second : nullptr;
+    }
+
+    void SQLWriteBehind::_flush(Id id, Buffer &buffer)
+    {
+        buffer.lastFlush = Clock::now();
+
+        if (buffer.rows.empty())
+        {
+            return;
+        }
+
+        std::size_t count = buffer.rows.size();
+
+        std::vector<MDBSQL::Value> values = std::move(buffer.values);
+        buffer.values.clear();
+        buffer.rows.clear();
+
+        m_inFlight += count;
+
+        // Kept until the batch has finished so a failed flush can be retried
+        auto retry = std::make_shared<std::vector<MDBSQL::Value>>(values);
+
+        SQLDispatcher::JobId jobId =
+            gSQLDispatcher->submitBatch(*buffer.connection, buffer.sql, std::move(values), buffer.columns,
+                                        [this, id, count, retry](const SQLDispatcher::Completion &completion)
+                                        {
+                                            _onFlushed(id, count, *retry, completion);
+                                        });
+
+        // MariaDB extension is not loaded
+        if (!jobId)
+        {
+            m_inFlight -= count;
+            m_failures++;
+            m_dropped += count;
+        }
+    }
+
+    void SQLWriteBehind::_onFlushed(Id id, std::size_t count, std::vector<MDBSQL::Value> &values,
+                                    const SQLDispatcher::Completion &completion)
+    {
+        m_inFlight -= count;
+        m_flushes++;
+        m_lastFlushUs = completion.elapsedUs;
+
+        auto it = m_buffers.find(id);
+
+        if (completion.success)
+        {
+            m_written += count;
+
+            if (it != m_buffers.end())
+            {
+                it->second.retries = 0;
+            }
+
+            return;
+        }
+
+        m_failures++;
+
+        if (it == m_buffers.end() || ++it->second.retries > MAX_RETRIES)
+        {
+            m_dropped += count;
+
+            std::string warn = fmt::format("Write-behind buffer {} dropped its rows after a failed flush: {}", id,
+                                           completion.error);
+            gLogger->logMsg(Anubis::LogDest::ConsoleFile, Anubis::LogLevel::Warning, warn);
+
+            if (it != m_buffers.end())
+            {
+                it->second.retries = 0;
+            }
+
+            return;
+        }
+
+        _requeue(it->second, values);
+
+        std::string warn = fmt::format("Write-behind buffer {} ({}) failed to flush {} rows, retrying: {}", id,
+                                       it->second.sql, count, completion.error);
+        gLogger->logMsg(Anubis::LogDest::ConsoleFile, Anubis::LogLevel::Warning, warn);
+    }
+
+    void SQLWriteBehind::_requeue(Buffer &buffer, std::vector<MDBSQL::Value> &values)
+    {
+        for (std::size_t offset = 0; offset + buffer.columns <= values.size(); offset += buffer.columns)
+        {
+            auto row = values.begin() + static_cast<std::ptrdiff_t>(offset);
+            Key key(row, row + static_cast<std::ptrdiff_t>(buffer.keyColumns));
+
+            auto existing = buffer.rows.find(key);
+            if (existing == buffer.rows.end())
+            {
+                buffer.rows.emplace(std::move(key), buffer.rows.size());
+                std::move(row, row + static_cast<std::ptrdiff_t>(buffer.columns), std::back_inserter(buffer.values));
+                continue;
+            }
+
+            MDBSQL::Value *newer = buffer.values.data() + existing->second * buffer.columns;
+
+            // Newer values win, only amounts still have to be added up
+            for (std::size_t i = buffer.keyColumns; i < buffer.columns; i++)
+            {
+                if (i < buffer.merge.size() && buffer.merge[i] == MergeMode::Add)
+                {
+                    _merge(newer[i], std::move(row[i]));
+                }
+            }
+        }
+    }
+
+    void SQLWriteBehind::_removeIf(const std::function<bool(const Buffer &)> &pred)
+    {
+        std::vector<MDBSQL::IConnection *> connections;
+
+        for (auto it = m_buffers.begin(); it != m_buffers.end();)
+        {
+            if (!pred(it->second))
+            {
+                ++it;
+                continue;
+            }
+
+            _flush(it->first, it->second);
+            connections.push_back(it->second.connection);
+
+            it = m_buffers.erase(it);
+        }
+
+        // Rows must reach the database before the connection or plugin is gone
+        for (MDBSQL::IConnection *connection : connections)
+        {
+            gSQLDispatcher->drain(*connection);
+        }
+    }
+
+    // Adds numbers up, other values are replaced
+    void SQLWriteBehind::_merge(MDBSQL::Value &into, MDBSQL::Value &&value)
+    {
+        if (auto total = std::get_if<std::int64_t>(&into); total)
+        {
+            if (auto number = std::get_if<std::int64_t>(&value); number)
+            {
+                *total += *number;
+                return;
+            }
+
+            if (auto real = std::get_if<double>(&value); real)
+            {
+                into = static_cast<double>(*total) + *real;
+                return;
+            }
+        }
+        else if (auto total = std::get_if<double>(&into); total)
+        {
+            if (auto number = std::get_if<std::int64_t>(&value); number)
+            {
+                *total += static_cast<double>(*number);
+                return;
+            }
+
+            if (auto real = std::get_if<double>(&value); real)
+            {
+                *total += *real;
+                return;
+            }
+        }
+
+        into = std::move(value);
+    }
+}
+
+std::unique_ptr<Luna::SQLWriteBehind> gSQLWriteBehind;
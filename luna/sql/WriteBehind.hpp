@@ -0,0 +1,145 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <mariadbsql/IAsyncExecutor.hpp>
+
+#include <chrono>
+#include <functional>
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+struct lua_State;
+
+namespace Luna::MDBSQL
+{
+    class IConnection;
+}
+
+namespace Luna
+{
+    /**
+     * @brief Coalesces keyed upserts in memory and writes them behind in batches.
+     *
+     * The first key columns of a row identify it. When a key is written again,
+     * numbers in columns merged by adding are added up and every other column
+     * is replaced. A buffer is flushed as one transaction on a worker thread once
+     * it is old or big enough, on map change and before its connection or
+     * plugin goes away. Rows of a failed flush are merged back and retried with
+     * the next flush, a buffer failing too often in a row drops them.
+     */
+    class SQLWriteBehind
+    {
+    public:
+        using Id = std::uint32_t;
+
+        enum class MergeMode : std::uint8_t
+        {
+            Replace = 0,
+            Add
+        };
+
+        struct Stats
+        {
+            // Rows waiting in buffers or being written
+            std::size_t backlog;
+            std::uint64_t submitted;
+            std::uint64_t written;
+            std::uint64_t flushes;
+            std::uint64_t failures;
+            // Rows given up on after failed flushes
+            std::uint64_t dropped;
+            std::uint64_t lastFlushUs;
+        };
+
+    public:
+        SQLWriteBehind(float flushInterval, std::size_t maxPending);
+
+        // Merge modes are given per column, missing ones replace
+        [[nodiscard]] Id create(lua_State *L, MDBSQL::IConnection &connection, std::string_view sql,
+                                std::size_t keyColumns, std::vector<MergeMode> &&merge);
+        // Buffers can only be used by the plugin that created them
+        [[nodiscard]] bool add(lua_State *L, Id id, std::vector<MDBSQL::Value> &&row);
+        void flush(lua_State *L, Id id);
+        void destroy(lua_State *L, Id id);
+        void update();
+        void flushAll();
+        void release(MDBSQL::IConnection &connection);
+        void drop(lua_State *L);
+
+        [[nodiscard]] Stats getStats() const;
+
+    private:
+        using Clock = std::chrono::steady_clock;
+        using Key = std::vector<MDBSQL::Value>;
+
+        struct KeyHash
+        {
+            std::size_t operator()(const Key &key) const;
+        };
+
+        struct Buffer
+        {
+            lua_State *L;
+            MDBSQL::IConnection *connection;
+            std::string sql;
+            std::size_t keyColumns;
+            std::size_t columns;
+            std::vector<MergeMode> merge;
+            // Coalesced rows, row-major as they are sent to the batch
+            std::vector<MDBSQL::Value> values;
+            std::unordered_map<Key, std::size_t, KeyHash> rows;
+            Clock::time_point lastFlush;
+            // Failed flushes in a row
+            std::uint32_t retries;
+        };
+
+        // Consecutive failed flushes after which a buffer's rows are dropped
+        static constexpr std::uint32_t MAX_RETRIES = 3;
+
+    private:
+        [[nodiscard]] Buffer *_find(lua_State *L, Id id);
+        void _flush(Id id, Buffer &buffer);
+        void _onFlushed(Id id, std::size_t count, std::vector<MDBSQL::Value> &values,
+                        const MDBSQL::IAsyncExecutor::Completion &completion);
+        // Merges rows of a failed flush back, rows added since then take precedence
+        void _requeue(Buffer &buffer, std::vector<MDBSQL::Value> &values);
+        void _removeIf(const std::function<bool(const Buffer &)> &pred);
+        static void _merge(MDBSQL::Value &into, MDBSQL::Value &&value);
+
+    private:
+        std::unordered_map<Id, Buffer> m_buffers;
+        Id m_nextId = 1;
+        Clock::duration m_flushInterval;
+        std::size_t m_maxPending;
+        std::size_t m_inFlight{};
+        std::uint64_t m_submitted{};
+        std::uint64_t m_written{};
+        std::uint64_t m_flushes{};
+        std::uint64_t m_failures{};
+        std::uint64_t m_dropped{};
+        std::uint64_t m_lastFlushUs{};
+    };
+}
+
+extern std::unique_ptr<Luna::SQLWriteBehind> gSQLWriteBehind;
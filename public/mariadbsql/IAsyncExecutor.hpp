@@ -0,0 +1,100 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "Value.hpp"
+#include "ICursor.hpp"
+
+#include <cinttypes>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Luna::MDBSQL
+{
+    class IConnection;
+
+    /**
+     * @brief Runs queries on worker threads.
+     *
+     * Queries on the same connection run one at a time in submission order.
+     * Finished queries wait in a completion queue until they are polled from
+     * the game thread.
+     */
+    class IAsyncExecutor
+    {
+    public:
+        using JobId = std::uint64_t;
+
+        enum class Kind : std::uint8_t
+        {
+            Query = 0,
+            Update,
+            Batch,
+            Cursor
+        };
+
+        struct Completion
+        {
+            JobId id;
+            bool success;
+            std::string error;
+            std::int64_t updateCount;
+            Rows rows;
+            // Time spent running the job on the worker
+            std::uint64_t elapsedUs;
+        };
+
+        struct Stats
+        {
+            std::size_t queued;
+            std::size_t running;
+            std::size_t completed;
+            std::uint64_t processed;
+        };
+
+    public:
+        virtual ~IAsyncExecutor() = default;
+
+        virtual void start(std::size_t workers) = 0;
+        virtual void stop() = 0;
+        virtual JobId submit(IConnection &connection, Kind kind, std::string_view sql, std::vector<Value> &&params) = 0;
+        /**
+         * @brief Runs rows of params (columns values each) as one batch inside a single transaction.
+         */
+        virtual JobId submitBatch(IConnection &connection, std::string_view sql, std::vector<Value> &&values,
+                                  std::size_t columns) = 0;
+        /**
+         * @brief Streams the query's rows into the returned cursor, fetchSize rows at a time.
+         *
+         * The worker keeps at most maxBuffered rows ahead of the consumer. Destroying the cursor stops it.
+         */
+        virtual std::unique_ptr<ICursor> openCursor(IConnection &connection, std::string_view sql,
+                                                    std::vector<Value> &&params, std::size_t fetchSize,
+                                                    std::size_t maxBuffered) = 0;
+        virtual void release(IConnection &connection) = 0;
+        // Blocks until every job submitted for the connection has finished, open cursors are closed first
+        virtual void drain(IConnection &connection) = 0;
+        // True while the connection has queued or running jobs, it must not be used from the game thread then
+        [[nodiscard]] virtual bool isBusy(IConnection &connection) const = 0;
+        virtual std::size_t poll(std::vector<Completion> &completions, std::size_t max) = 0;
+        virtual Stats getStats() const = 0;
+    };
+}
\ No newline at end of file
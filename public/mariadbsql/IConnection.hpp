@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <memory>
 
@@ -27,12 +28,50 @@ namespace Luna::MDBSQL
     class IStatement;
     class IPreparedStatement;
 
+    struct StatementCacheStats
+    {
+        std::size_t size;
+        std::size_t capacity;
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+    };
+
     class IConnection
     {
     public:
         virtual ~IConnection() = default;
 
         virtual std::unique_ptr<IStatement> createStatement() = 0;
+        /**
+         * @brief Statements prepared for SQL text seen before are taken from a per-connection LRU cache.
+         */
         virtual std::unique_ptr<IPreparedStatement> prepareStatement(std::string_view sql) = 0;
+        virtual StatementCacheStats getStatementCacheStats() = 0;
+
+        virtual void setAutoCommit(bool autoCommit) = 0;
+        virtual bool getAutoCommit() = 0;
+
+        /**
+         * @brief Transactions, errors are reported by throwing std::exception.
+         *
+         * In group commit mode begin() joins a shared transaction and each small
+         * transaction is kept apart by a savepoint. commit() only releases that
+         * savepoint, the shared transaction is committed by flushGroupCommit()
+         * once the window has passed. Only one transaction can be inside the
+         * group at a time, one left open for too long is rolled back so the
+         * rest of the group can be committed.
+         */
+        virtual void begin() = 0;
+        virtual void commit() = 0;
+        virtual void rollback() = 0;
+        virtual void setSavepoint(std::string_view name) = 0;
+        virtual void releaseSavepoint(std::string_view name) = 0;
+        virtual void rollbackToSavepoint(std::string_view name) = 0;
+
+        // Window of 0 turns group commit off and commits the pending group, refused inside a transaction
+        virtual void setGroupCommit(std::uint32_t windowMs) = 0;
+        // Returns true when the pending group was committed
+        virtual bool flushGroupCommit(bool force) = 0;
     };
 }
\ No newline at end of file
@@ -0,0 +1,62 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include "Value.hpp"
+
+#include <cinttypes>
+#include <string>
+
+namespace Luna::MDBSQL
+{
+    /**
+     * @brief Rows of a query streamed in chunks by a worker thread.
+     *
+     * The worker reads fetch size rows at a time and parks the query once the
+     * buffer is full, so only a bounded part of the result is held in memory.
+     * A parked query does not hold a worker, taking rows continues it. The
+     * connection stays busy until the cursor is exhausted or closed.
+     */
+    class ICursor
+    {
+    public:
+        struct Stats
+        {
+            std::size_t buffered;
+            std::uint64_t fetched;
+            std::uint64_t taken;
+        };
+
+    public:
+        virtual ~ICursor() = default;
+
+        /**
+         * @brief Moves up to max buffered rows into rows without waiting for the worker.
+         *
+         * @return Number of rows taken, 0 when nothing is buffered yet.
+         */
+        virtual std::size_t take(Rows &rows, std::size_t max) = 0;
+        // Every row was taken or the query failed
+        [[nodiscard]] virtual bool isDone() const = 0;
+        [[nodiscard]] virtual std::string getError() const = 0;
+        // Stops the query, rows still buffered are dropped
+        virtual void close() = 0;
+        [[nodiscard]] virtual Stats getStats() const = 0;
+    };
+}
\ No newline at end of file
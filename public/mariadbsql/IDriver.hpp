@@ -27,9 +27,29 @@
 namespace Luna::MDBSQL
 {
     class IConnection;
+    class IAsyncExecutor;
 
     using Properties = std::map<std::string, std::string>;
 
+    struct PoolConfig
+    {
+        std::string url;
+        Properties properties;
+        std::size_t minSize;
+        std::size_t maxSize;
+        // Seconds an idle connection above minSize is kept open
+        std::uint32_t idleTimeout;
+    };
+
+    struct PoolStats
+    {
+        std::size_t idle;
+        std::size_t leased;
+        std::uint64_t created;
+        std::uint64_t reused;
+        std::uint64_t discarded;
+    };
+
     class IDriver
     {
     public:
@@ -43,5 +63,18 @@ namespace Luna::MDBSQL
         virtual uint32_t getMinorVersion() = 0;
         virtual bool jdbcCompliant() = 0;
         virtual std::string_view getName() = 0;
+        virtual IAsyncExecutor &getAsyncExecutor() = 0;
+
+        /**
+         * @brief Prepared statements cached per connection opened afterwards, 0 disables the cache.
+         */
+        virtual void setStatementCacheSize(std::size_t size) = 0;
+
+        /**
+         * @brief Connections acquired from a pool go back to it when destroyed.
+         */
+        virtual bool createPool(std::string_view name, const PoolConfig &config) = 0;
+        virtual std::unique_ptr<IConnection> acquire(std::string_view name) = 0;
+        virtual PoolStats getPoolStats(std::string_view name) = 0;
     };
 }
\ No newline at end of file
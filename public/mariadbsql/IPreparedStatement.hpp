@@ -20,6 +20,9 @@
 #pragma once
 
 #include "IStatement.hpp"
+#include "Value.hpp"
+
+#include <vector>
 
 namespace Luna::MDBSQL
 {
@@ -49,5 +52,14 @@ namespace Luna::MDBSQL
         virtual void setFloat(int32_t parameterIndex, float value) = 0;
         virtual void setDouble(int32_t parameterIndex, double value) = 0;
         virtual void setBigInt(int32_t parameterIndex, std::string_view value) = 0;
+
+        /**
+         * @brief Binds each row of values (row-major, columns values per row) and sends them as one batch.
+         *
+         * With rewrite set, a single-row INSERT is sent as multi-row INSERTs instead of a row per statement.
+         *
+         * @return Total number of affected rows.
+         */
+        virtual int64_t executeBatch(const std::vector<Value> &values, std::size_t columns, bool rewrite) = 0;
     };
 }
\ No newline at end of file
@@ -19,6 +19,8 @@
 
 #pragma once
 
+#include "Value.hpp"
+
 #include <memory>
 #include <cinttypes>
 #include <string>
@@ -92,5 +94,18 @@ namespace Luna::MDBSQL
         virtual std::int16_t getShort(std::string_view columnLabel) const = 0;
 
         virtual std::int32_t findColumn(std::string_view columnLabel) const = 0;
+
+        /**
+         * @brief Converts up to max rows (0 for all) following the cursor in one call.
+         *
+         * @return Number of rows read, fewer than max once the result set is exhausted.
+         */
+        virtual std::size_t fetch(Rows &rows, std::size_t max) = 0;
+
+        /**
+         * @brief Column labels and types in column order, index 0 is column 1.
+         */
+        virtual const std::vector<std::string> &getColumnNames() const = 0;
+        virtual const std::vector<ColumnType> &getColumnTypes() const = 0;
     };
 }
\ No newline at end of file
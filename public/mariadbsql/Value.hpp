@@ -0,0 +1,55 @@
+/*
+ *  Copyright (C) 2023 Karol Szuster
+ *
+ *  This file is part of Luna.
+ *
+ *  Luna is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+
+ *  Luna is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+
+ *  You should have received a copy of the GNU General Public License
+ *  along with Luna.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <variant>
+#include <vector>
+
+namespace Luna::MDBSQL
+{
+    enum class ColumnType : std::uint8_t
+    {
+        Null = 0,
+        Bool,
+        Integer,
+        Float,
+        String
+    };
+
+    using Value = std::variant<std::monostate, bool, std::int64_t, double, std::string>;
+
+    /**
+     * @brief Result set copied out of the connector.
+     *
+     * Values are stored row-major, each row holds one value per column.
+     */
+    struct Rows
+    {
+        std::vector<std::string> columns;
+        std::vector<ColumnType> types;
+        std::vector<Value> values;
+
+        [[nodiscard]] std::size_t getRowCount() const
+        {
+            return columns.empty() ? 0 : values.size() / columns.size();
+        }
+    };
+}
\ No newline at end of file